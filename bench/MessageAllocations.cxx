@@ -0,0 +1,158 @@
+/**
+ * @file MessageAllocations.cxx
+ * @brief Count the heap allocations made per logged message
+ *
+ * Compares the MessageSource path against a copy of the original implementation, in which each
+ * message built a std::stringbuf, copied the source name and was copied into the queue as a
+ * Message holding owning strings. Messages are logged in bursts, waiting for the consumer to catch
+ * up after each one, which is the steady state of a logger that keeps up with its producers.
+ */
+
+#include "AsyncQueue/IBatchConsumer.hxx"
+#include "AsyncQueue/ManagedQueue.hxx"
+#include "AsyncQueue/MessageManager.hxx"
+#include "AsyncQueue/MessageSource.hxx"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+    std::atomic<std::size_t> allocations{0};
+} // namespace
+
+void *operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace {
+    using namespace AsyncQueue;
+
+    constexpr std::size_t burstSize = 100;
+    constexpr std::size_t nBursts = 1000;
+    constexpr std::size_t nWarmup = 10;
+
+    /// @brief The message type before source interning and pooled text
+    struct LegacyMessage {
+        const std::string source;
+        const std::chrono::time_point<std::chrono::system_clock> time;
+        const MessageLevel level;
+        const std::string message;
+    };
+
+    /// @brief The original MessageQueueBuffer
+    class LegacyBuffer : public std::stringbuf {
+    public:
+        LegacyBuffer(
+                ManagedQueue<LegacyMessage> &queue, MessageLevel lvl, const std::string &source)
+                : std::stringbuf(std::ios::out), m_queue(queue), m_lvl(lvl), m_source(source) {}
+
+    protected:
+        int sync() override {
+            if (!str().empty())
+                m_queue.push(
+                        {.source = m_source,
+                         .time = std::chrono::system_clock::now(),
+                         .level = m_lvl,
+                         .message = str()});
+            str("");
+            return 0;
+        }
+
+    private:
+        ManagedQueue<LegacyMessage> &m_queue;
+        const MessageLevel m_lvl;
+        const std::string m_source;
+    };
+
+    /// @brief The original MessageQueueStream
+    class LegacyStream : public std::ostream {
+    public:
+        LegacyStream(
+                ManagedQueue<LegacyMessage> &queue, MessageLevel lvl, const std::string &source)
+                : std::ostream(&m_buffer), m_buffer(queue, lvl, source) {}
+        ~LegacyStream() { flush(); }
+
+    private:
+        LegacyBuffer m_buffer;
+    };
+
+    /// @brief Consumer which discards its input, counting what it has seen
+    template <typename T> class CountingConsumer : public IBatchConsumer<T> {
+    public:
+        CountingConsumer(std::atomic<std::size_t> &count) : m_count(count) {}
+        using IBatchConsumer<T>::consume;
+        TaskStatus consume(std::span<const T> batch) override {
+            m_count.fetch_add(batch.size(), std::memory_order_release);
+            return TaskStatus::CONTINUE;
+        }
+
+    private:
+        std::atomic<std::size_t> &m_count;
+    };
+
+    void waitFor(const std::atomic<std::size_t> &count, std::size_t target) {
+        while (count.load(std::memory_order_acquire) < target)
+            std::this_thread::yield();
+    }
+
+    /// @brief Run log in bursts and report the allocations and time per message
+    template <typename F>
+    void measure(const char *name, const std::atomic<std::size_t> &consumed, F &&log) {
+        const std::size_t offset = consumed.load();
+        std::size_t sent = 0;
+        auto burst = [&]() {
+            for (std::size_t idx = 0; idx < burstSize; ++idx)
+                log(sent++);
+            waitFor(consumed, offset + sent);
+        };
+        for (std::size_t idx = 0; idx < nWarmup; ++idx)
+            burst();
+        std::size_t before = allocations.load();
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t idx = 0; idx < nBursts; ++idx)
+            burst();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        std::size_t count = burstSize * nBursts;
+        std::printf(
+                "%-28s %8.3f allocations/message %8.1f ns/message\n", name,
+                static_cast<double>(allocations.load() - before) / count,
+                std::chrono::duration<double, std::nano>(elapsed).count() / count);
+    }
+} // namespace
+
+int main() {
+    {
+        std::atomic<std::size_t> consumed{0};
+        ManagedQueue<LegacyMessage> queue(CountingConsumer<LegacyMessage>{consumed});
+        const std::string name = "Benchmark";
+        measure("baseline (stringbuf)", consumed, [&](std::size_t idx) {
+            LegacyStream(queue, MessageLevel::INFO, name)
+                    << "iteration " << idx << " of the allocation benchmark";
+        });
+    }
+    {
+        std::atomic<std::size_t> consumed{0};
+        MessageManager manager(CountingConsumer<Message>{consumed});
+        MessageSource source = manager.createSource("Benchmark");
+        measure("MessageSource stream", consumed, [&](std::size_t idx) {
+            source.infoMsg() << "iteration " << idx << " of the allocation benchmark";
+        });
+        measure("MessageSource variadic", consumed, [&](std::size_t idx) {
+            source.infoMsg("iteration ", idx, " of the allocation benchmark");
+        });
+    }
+    return 0;
+}
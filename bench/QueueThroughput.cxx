@@ -0,0 +1,324 @@
+/**
+ * @file QueueThroughput.cxx
+ * @brief Throughput and latency of the queues and the message pipeline
+ *
+ * Usage: QueueThroughput [--items N] [--filter REGEX]
+ *
+ * Each benchmark pushes items from a number of producer threads as fast as it can and reports,
+ * in the style of Google Benchmark, the time taken for all of them to be consumed, the items
+ * consumed per second and percentiles of the time from each push to its consumption. Latencies
+ * are measured by the benchmark's own consumers so are reported whether or not the library was
+ * built with AsyncQueue_INSTRUMENT. If it was, the queue's high-water mark and lock contention
+ * are reported as well.
+ */
+
+#include "AsyncQueue/AsyncQueue.hxx"
+#include "AsyncQueue/IBatchConsumer.hxx"
+#include "AsyncQueue/ManagedQueue.hxx"
+#include "AsyncQueue/MessageManager.hxx"
+#include "AsyncQueue/MessageSource.hxx"
+#include "AsyncQueue/QueueStats.hxx"
+#include "AsyncQueue/TeeConsumer.hxx"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+    using namespace AsyncQueue;
+    using std::chrono::steady_clock;
+
+    constexpr std::size_t defaultItems = 200000;
+    constexpr std::size_t threadCounts[] = {1, 2, 4};
+
+    void usage(std::ostream &os) {
+        os << "Usage: QueueThroughput [options]\n"
+              "\n"
+              "Measure the throughput and latency of the queues and the message pipeline.\n"
+              "\n"
+              "Options:\n"
+              "  -n, --items N         The number of items pushed by each benchmark, shared\n"
+              "                        between its producers. Default "
+           << defaultItems
+           << "\n"
+              "  -f, --filter REGEX    Only run benchmarks whose names match REGEX\n"
+              "  -h, --help            Print this message\n";
+    }
+
+    /// @brief The element pushed through the queues
+    struct Item {
+        steady_clock::time_point pushed;
+    };
+
+    /// @brief When an element was pushed
+    /// @{
+    steady_clock::time_point pushTime(const Item &item) { return item.pushed; }
+    std::chrono::system_clock::time_point pushTime(const Message &message) { return message.time; }
+    /// @}
+
+    /// @brief Consumer which records the latency of each element it receives
+    template <typename T> class LatencyConsumer : public IBatchConsumer<T> {
+    public:
+        using clock = typename decltype(pushTime(std::declval<const T &>()))::clock;
+
+        using IBatchConsumer<T>::consume;
+        TaskStatus consume(std::span<const T> batch) override {
+            auto now = clock::now();
+            for (const T &element : batch)
+                m_latency.record(now - pushTime(element));
+            m_count.fetch_add(batch.size(), std::memory_order_release);
+            return TaskStatus::CONTINUE;
+        }
+
+        /// @brief The number of elements consumed so far
+        std::size_t count() const { return m_count.load(std::memory_order_acquire); }
+
+        /// @brief The latencies recorded so far. Only safe to read while the consumer is idle
+        const LatencyHistogram &latency() const { return m_latency; }
+
+    private:
+        LatencyHistogram m_latency;
+        std::atomic<std::size_t> m_count{0};
+    };
+
+    /// @brief The outcome of a single benchmark
+    struct Result {
+        /// @brief The time from the first push until every item was consumed
+        steady_clock::duration elapsed{};
+        std::size_t items{0};
+        LatencyHistogram latency{};
+        QueueStats stats{};
+    };
+
+    /// @brief Wait until count reaches target
+    template <typename F> void waitFor(F &&count, std::size_t target) {
+        while (count() < target)
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    /// @brief Call push(producer) perProducer times on each of nProducers threads
+    template <typename F> void produce(std::size_t nProducers, std::size_t perProducer, F &&push) {
+        std::vector<std::jthread> producers;
+        for (std::size_t producer = 0; producer < nProducers; ++producer)
+            producers.emplace_back([&push, perProducer, producer]() {
+                for (std::size_t idx = 0; idx < perProducer; ++idx)
+                    push(producer);
+            });
+    }
+
+    /// @brief Several consumers looped directly on an AsyncQueue
+    Result benchAsyncQueue(std::size_t nProducers, std::size_t nConsumers, std::size_t nItems) {
+        const std::size_t perProducer = nItems / nProducers;
+        ::AsyncQueue::AsyncQueue<Item> queue;
+        std::stop_source ss;
+        std::vector<LatencyHistogram> latencies(nConsumers);
+        std::atomic<std::size_t> consumed{0};
+        std::vector<std::future<TaskStatus>> consumers;
+        for (LatencyHistogram &latency : latencies)
+            consumers.push_back(queue.loopConsumer(ss, [&latency, &consumed](const Item &item) {
+                latency.record(steady_clock::now() - item.pushed);
+                consumed.fetch_add(1, std::memory_order_release);
+                return TaskStatus::CONTINUE;
+            }));
+
+        Result result{.items = perProducer * nProducers};
+        auto start = steady_clock::now();
+        produce(nProducers, perProducer, [&queue](std::size_t) {
+            queue.push(Item{steady_clock::now()});
+        });
+        waitFor([&consumed]() { return consumed.load(std::memory_order_acquire); }, result.items);
+        result.elapsed = steady_clock::now() - start;
+        ss.request_stop();
+        for (auto &consumer : consumers)
+            consumer.get();
+        for (const LatencyHistogram &latency : latencies)
+            result.latency += latency;
+        result.stats = queue.stats();
+        return result;
+    }
+
+    /// @brief A ManagedQueue passing batches to its consumer
+    Result benchManagedQueue(std::size_t nProducers, std::size_t nItems) {
+        const std::size_t perProducer = nItems / nProducers;
+        LatencyConsumer<Item> consumer;
+        Result result{.items = perProducer * nProducers};
+        ManagedQueue<Item> queue(&consumer);
+        auto start = steady_clock::now();
+        produce(nProducers, perProducer, [&queue](std::size_t) {
+            queue.push(Item{steady_clock::now()});
+        });
+        waitFor([&consumer]() { return consumer.count(); }, result.items);
+        result.elapsed = steady_clock::now() - start;
+        result.latency = consumer.latency();
+        result.stats = queue.stats();
+        return result;
+    }
+
+    /// @brief A ManagedQueue whose TeeConsumer forwards every batch to several consumers
+    Result benchTeeConsumer(std::size_t nProducers, std::size_t nConsumers, std::size_t nItems) {
+        const std::size_t perProducer = nItems / nProducers;
+        std::vector<LatencyConsumer<Item>> consumers(nConsumers);
+        TeeConsumer<Item> tee;
+        for (LatencyConsumer<Item> &consumer : consumers)
+            tee.addConsumer(&consumer);
+        Result result{.items = perProducer * nProducers};
+        ManagedQueue<Item> queue(&tee);
+        auto start = steady_clock::now();
+        produce(nProducers, perProducer, [&queue](std::size_t) {
+            queue.push(Item{steady_clock::now()});
+        });
+        for (const LatencyConsumer<Item> &consumer : consumers)
+            waitFor([&consumer]() { return consumer.count(); }, result.items);
+        result.elapsed = steady_clock::now() - start;
+        for (const LatencyConsumer<Item> &consumer : consumers)
+            result.latency += consumer.latency();
+        result.stats = queue.stats();
+        return result;
+    }
+
+    /// @brief Messages logged through MessageSources to a writer
+    Result benchMessageManager(std::size_t nProducers, std::size_t nItems) {
+        const std::size_t perProducer = nItems / nProducers;
+        auto writer = std::make_unique<LatencyConsumer<Message>>();
+        const LatencyConsumer<Message> &observed = *writer;
+        Result result{.items = perProducer * nProducers};
+        MessageManager manager(std::move(writer));
+        std::vector<MessageSource> sources;
+        for (std::size_t producer = 0; producer < nProducers; ++producer)
+            sources.push_back(manager.createSource("Producer" + std::to_string(producer)));
+        auto start = steady_clock::now();
+        produce(nProducers, perProducer, [&sources](std::size_t producer) {
+            sources[producer].infoMsg("benchmark message from producer ", producer);
+        });
+        waitFor([&observed]() { return observed.count(); }, result.items);
+        result.elapsed = steady_clock::now() - start;
+        result.latency = observed.latency();
+        result.stats = manager.stats();
+        return result;
+    }
+
+    /// @brief Format a value with a k, M or G suffix
+    std::string humanise(double value) {
+        const char *suffix = "";
+        for (const char *next : {"k", "M", "G"}) {
+            if (value < 1000)
+                break;
+            value /= 1000;
+            suffix = next;
+        }
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.4g%s", value, suffix);
+        return text;
+    }
+
+    /// @brief Format a duration in the most readable unit
+    std::string formatDuration(std::chrono::nanoseconds duration) {
+        double value = duration.count();
+        const char *unit = "ns";
+        for (const char *next : {"us", "ms", "s"}) {
+            if (value < 1000)
+                break;
+            value /= 1000;
+            unit = next;
+        }
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.4g %s", value, unit);
+        return text;
+    }
+
+    void printHeader() {
+        std::string line(100, '-');
+        std::printf("%s\n", line.c_str());
+        std::printf(
+                "%-44s %12s %14s %11s %11s\n", "Benchmark", "Time", "Items/s", "p50", "p99");
+        std::printf("%s\n", line.c_str());
+    }
+
+    void report(const std::string &name, const Result &result) {
+        double seconds = std::chrono::duration<double>(result.elapsed).count();
+        std::printf(
+                "%-44s %12s %14s %11s %11s", name.c_str(),
+                formatDuration(result.elapsed).c_str(),
+                (humanise(result.items / seconds) + "/s").c_str(),
+                formatDuration(result.latency.percentile(50)).c_str(),
+                formatDuration(result.latency.percentile(99)).c_str());
+        if constexpr (queueInstrumentation)
+            std::printf(
+                    " highWaterMark=%zu contended=%s serviceP99=%s", result.stats.highWaterMark,
+                    humanise(result.stats.contended).c_str(),
+                    formatDuration(result.stats.serviceTime.percentile(99)).c_str());
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::size_t nItems = defaultItems;
+    std::optional<std::regex> filter;
+    try {
+        for (int idx = 1; idx < argc; ++idx) {
+            std::string_view arg(argv[idx]);
+            auto value = [&]() -> std::string {
+                if (idx + 1 >= argc)
+                    throw std::invalid_argument("Missing value for " + std::string(arg));
+                return argv[++idx];
+            };
+            if (arg == "-h" || arg == "--help") {
+                usage(std::cout);
+                return 0;
+            } else if (arg == "-n" || arg == "--items")
+                nItems = std::stoull(value());
+            else if (arg == "-f" || arg == "--filter")
+                filter.emplace(value());
+            else
+                throw std::invalid_argument("Unknown option " + std::string(arg));
+        }
+        if (nItems == 0)
+            throw std::invalid_argument("The number of items must be positive");
+    } catch (const std::exception &e) {
+        std::cerr << "QueueThroughput: " << e.what() << "\n\n";
+        usage(std::cerr);
+        return 1;
+    }
+
+    auto run = [&filter](const std::string &name, auto &&benchmark) {
+        if (!filter || std::regex_search(name, *filter))
+            report(name, benchmark());
+    };
+    auto threads = [](std::size_t producers, std::size_t consumers) {
+        return "/producers:" + std::to_string(producers) + "/consumers:" +
+               std::to_string(consumers);
+    };
+
+    printHeader();
+    for (std::size_t producers : threadCounts)
+        for (std::size_t consumers : threadCounts)
+            run("AsyncQueue" + threads(producers, consumers), [&]() {
+                return benchAsyncQueue(producers, consumers, nItems);
+            });
+    for (std::size_t producers : threadCounts)
+        run("ManagedQueue" + threads(producers, 1),
+            [&]() { return benchManagedQueue(producers, nItems); });
+    for (std::size_t producers : threadCounts)
+        for (std::size_t consumers : threadCounts)
+            run("TeeConsumer" + threads(producers, consumers), [&]() {
+                return benchTeeConsumer(producers, consumers, nItems);
+            });
+    for (std::size_t producers : threadCounts)
+        run("MessageManager" + threads(producers, 1),
+            [&]() { return benchMessageManager(producers, nItems); });
+    return 0;
+}
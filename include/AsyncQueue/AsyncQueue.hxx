@@ -6,26 +6,43 @@
 #ifndef ASYNCQUEUE_ASYNCQUEUE_HXX
 #define ASYNCQUEUE_ASYNCQUEUE_HXX
 
+#include "AsyncQueue/Batch.hxx"
 #include "AsyncQueue/Fwd.hxx"
 #include "AsyncQueue/Loop.hxx"
+#include "AsyncQueue/Overflow.hxx"
+#include "AsyncQueue/QueueStats.hxx"
 #include "AsyncQueue/TaskStatus.hxx"
 #include "AsyncQueue/concepts.hxx"
 
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <functional>
 #include <future>
+#include <iterator>
 #include <mutex>
 #include <optional>
-#include <queue>
+#include <ranges>
+#include <span>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace AsyncQueue {
 #ifdef AsyncQueue_MULTITHREAD
+    /// @brief A looping task which produces elements for the queue type Q
+    template <typename F, typename Q, typename... Args>
+    concept QueueProducer = LoopingTask<F, std::reference_wrapper<Q>, Args...>;
+
     template <typename F, typename T, typename... Args>
-    concept Producer = LoopingTask<F, std::reference_wrapper<AsyncQueue<T>>, Args...>;
+    concept Producer = QueueProducer<F, AsyncQueue<T>, Args...>;
 
     template <typename F, typename T, typename... Args>
     concept Consumer = LoopingTask<F, T, Args...>;
+
+    /// @brief A looping task which consumes a contiguous batch of queue elements at once
+    template <typename F, typename T, typename... Args>
+    concept BatchConsumer = LoopingTask<F, std::span<const T>, Args...>;
 #endif
     /// @brief Asynchronous queue implementation
     /// @tparam T The data type stored in the queue
@@ -33,8 +50,16 @@ namespace AsyncQueue {
     /// Multiple consumers and producers can be looped on the queue. Each element of the queue will
     /// be sent to a single producer. This will be determined by the condition variable's notify_one
     /// method and should be assumed to be non-deterministic.
+    ///
+    /// By default the queue is unbounded. A capacity can be set with @ref setCapacity, in which
+    /// case the OverflowPolicy decides what happens to elements pushed while the queue is full.
+    ///
+    /// If the library is built with AsyncQueue_INSTRUMENT the queue also collects the statistics
+    /// returned by @ref stats. Contention is counted by @ref lock, so waits on the raw mutex are
+    /// not included.
     template <typename T> class AsyncQueue {
     public:
+        using value_type = T;
         using lock_t = std::unique_lock<std::mutex>;
 
         /// @brief Get the mutex protecting the queue
@@ -44,16 +69,76 @@ namespace AsyncQueue {
         /// @brief Get the condition variable for the queue
         std::condition_variable_any &cv();
 
+        /**
+         * @brief Bound the number of elements in the queue
+         * @param capacity The maximum number of elements. 0 means that the queue is unbounded
+         * @param policy What to do with elements pushed while the queue is full
+         *
+         * Without multithreading nothing can make space while a producer waits, so elements which
+         * would block are discarded instead and counted as DropCounts::newest.
+         */
+        void setCapacity(std::size_t capacity, OverflowPolicy policy = OverflowPolicy::Block);
+        /**
+         * @brief Bound the number of elements in the queue, dropping low severity messages first
+         * @param capacity The maximum number of elements. 0 means that the queue is unbounded
+         * @param dropBelow Elements pushed while the queue is full are discarded if their level is
+         *                  below this. Producers of other elements block until there is space.
+         */
+        void setCapacity(std::size_t capacity, MessageLevel dropBelow)
+            requires concepts::HasMessageLevel<T>;
+        /// @brief The maximum number of elements in the queue. 0 if the queue is unbounded
+        std::size_t capacity() const;
+        /// @brief What happens to elements pushed while the queue is full
+        OverflowPolicy overflowPolicy() const;
+        /// @brief The number of elements discarded by the overflow policy so far
+        DropCounts dropCounts() const;
+        /// @brief A snapshot of the queue's statistics, empty unless AsyncQueue_INSTRUMENT is set
+        QueueStats stats() const;
+
         /// @name Push methods
         /// The push methods take a const reference (copy) or an rvalue reference (move) to a value
         /// to add to the queue. For both version a lock can also be provided. In this case it
         /// *must* be the queue's own lock. If a lock isn't provided the @ref lock method will be
         /// used to supply one.
+        ///
+        /// If the queue is full and the overflow policy is to block then the lock is released
+        /// while waiting for space. The versions taking a stop token give up if it is stopped.
+        /// Returns false if the value was discarded.
+        /// @{
+        bool push(const T &value);
+        bool push(const T &value, const lock_t &lock);
+        bool push(T &&value);
+        bool push(T &&value, const lock_t &lock);
+#ifdef AsyncQueue_MULTITHREAD
+        bool push(const T &value, std::stop_token st);
+        bool push(const T &value, const lock_t &lock, std::stop_token st);
+        bool push(T &&value, std::stop_token st);
+        bool push(T &&value, const lock_t &lock, std::stop_token st);
+#endif
+        /// @}
+
+        /// @name Bulk push methods
+        /// Push several values while only acquiring the lock and notifying waiting consumers once.
+        /// pushRange copies each element of the range, pushBulk moves the elements out of the
+        /// provided vector. As for @ref push, a lock can be provided which *must* be the queue's
+        /// own lock, and a stop token can be provided to interrupt a blocked push. Each element is
+        /// subject to the overflow policy individually. Returns the number of elements accepted.
         /// @{
-        void push(const T &value);
-        void push(const T &value, const lock_t &lock);
-        void push(T &&value);
-        void push(T &&value, const lock_t &lock);
+        template <std::input_iterator It, std::sentinel_for<It> S>
+        std::size_t pushRange(It first, S last);
+        template <std::input_iterator It, std::sentinel_for<It> S>
+        std::size_t pushRange(It first, S last, const lock_t &lock);
+        template <std::ranges::input_range R> std::size_t pushRange(R &&range);
+        template <std::ranges::input_range R> std::size_t pushRange(R &&range, const lock_t &lock);
+        std::size_t pushBulk(std::vector<T> &&values);
+        std::size_t pushBulk(std::vector<T> &&values, const lock_t &lock);
+#ifdef AsyncQueue_MULTITHREAD
+        template <std::input_iterator It, std::sentinel_for<It> S>
+        std::size_t pushRange(It first, S last, std::stop_token st);
+        template <std::input_iterator It, std::sentinel_for<It> S>
+        std::size_t pushRange(It first, S last, const lock_t &lock, std::stop_token st);
+        std::size_t pushBulk(std::vector<T> &&values, std::stop_token st);
+#endif
         /// @}
 
         /**
@@ -74,6 +159,40 @@ namespace AsyncQueue {
          */
         std::optional<T> extract(const lock_t &lock);
 
+        /**
+         * @brief Extract up to maxCount elements from the front of the queue
+         *
+         * The elements are removed from the queue and appended to out in queue order. Thread safe
+         *
+         * @param out The vector to fill
+         * @param maxCount The maximum number of elements to extract
+         * @return The number of elements extracted
+         */
+        std::size_t extractBatch(std::vector<T> &out, std::size_t maxCount);
+
+        /**
+         * @brief Extract up to maxCount elements from the front of the queue
+         *
+         * The elements are removed from the queue and appended to out in queue order. The lock
+         * provided *must* be for the correct mutex and locked.
+         *
+         * @param out The vector to fill
+         * @param maxCount The maximum number of elements to extract
+         * @param lock Should be an already acquired lock to the correct mutex
+         * @return The number of elements extracted
+         */
+        std::size_t extractBatch(std::vector<T> &out, std::size_t maxCount, const lock_t &lock);
+
+        /**
+         * @brief Return extracted elements to the front of the queue
+         *
+         * Used for elements which were extracted but never consumed, e.g. because the consumer
+         * halted part way through a batch. They are moved out of values and placed ahead of any
+         * queued elements, in order. As they were admitted once already the capacity is ignored.
+         * Thread safe
+         */
+        void requeue(std::span<T> values);
+
         /// @brief Get the number of elements in the queue
         std::size_t size() const;
 
@@ -87,6 +206,32 @@ namespace AsyncQueue {
         bool empty(const lock_t &) const;
 
 #ifdef AsyncQueue_MULTITHREAD
+        /**
+         * @brief Block until the queue contains an element or a stop is requested
+         * @param st The stop token which interrupts the wait
+         * @return Whether the queue is non-empty
+         */
+        bool waitForElement(std::stop_token st);
+
+        /**
+         * @brief Block until the queue contains an element or a stop is requested
+         * @param st The stop token which interrupts the wait
+         * @param lock Should be an already acquired lock to the correct mutex
+         * @return Whether the queue is non-empty
+         */
+        bool waitForElement(std::stop_token st, lock_t &lock);
+
+        /**
+         * @brief Block until the queue contains at least count elements
+         * @param st The stop token which interrupts the wait
+         * @param count The number of elements to wait for
+         * @param deadline The latest time to wait until
+         * @return Whether the queue contains at least count elements
+         */
+        bool waitForElements(
+                std::stop_token st, std::size_t count,
+                const std::chrono::steady_clock::time_point &deadline);
+
         template <typename F, typename... Args>
             requires Producer<F, T, Args...>
         std::future<TaskStatus> loopProducer(std::stop_source ss, F &&f, Args &&...args) {
@@ -103,11 +248,136 @@ namespace AsyncQueue {
         template <typename F, typename... Args>
             requires Consumer<F, T, Args...>
         std::future<TaskStatus> loopConsumer(std::stop_source ss, F &&f, Args &&...args);
+
+        /// @brief Loop a consumer which only accepts batches of elements
+        ///
+        /// Functors which accept both single elements and batches are looped one element at a
+        /// time, use the overload taking BatchOptions to consume them in batches.
+        template <typename F, typename... Args>
+            requires(!Consumer<F, T, Args...>) && BatchConsumer<F, T, Args...>
+        std::future<TaskStatus> loopConsumer(std::stop_source ss, F &&f, Args &&...args) {
+            return loopConsumer(
+                    ss, BatchOptions{}, std::forward<F>(f), std::forward<Args>(args)...);
+        }
+
+        /// @brief Loop a consumer, passing it batches of elements
+        /// @param ss The stop source controlling execution
+        /// @param options Controls the maximum size of each batch and how long to wait for it to
+        ///                fill
+        /// @param f The functor to execute. Receives a std::span<const T> of extracted elements
+        /// @param args Any extra arguments to the functor
+        template <typename F, typename... Args>
+            requires BatchConsumer<F, T, Args...>
+        std::future<TaskStatus> loopConsumer(
+                std::stop_source ss, const BatchOptions &options, F &&f, Args &&...args);
+
+        /// @name Executor overloads
+        /// Run the producer or consumer as a sequence of tasks on a shared executor rather than on
+        /// a dedicated thread, see the executor overloads of loop. A consumer which finds the
+        /// queue empty is parked using @ref onElementReady and does not occupy a pool thread.
+        /// @{
+        template <typename F, typename... Args>
+            requires Producer<F, T, Args...>
+        std::future<TaskStatus> loopProducer(
+                Executor &executor, std::stop_source ss, F &&f, Args &&...args) {
+            return loop(
+                    executor, ss, std::forward<F>(f), std::ref(*this),
+                    std::forward<Args>(args)...);
+        }
+
+        template <concepts::Duration D, typename F, typename... Args>
+            requires Producer<F, T, Args...>
+        std::future<TaskStatus> loopProducer(
+                Executor &executor, std::stop_source ss, const D &d, F &&f, Args &&...args) {
+            return loop(
+                    executor, ss, d, std::forward<F>(f), std::ref(*this),
+                    std::forward<Args>(args)...);
+        }
+
+        template <typename F, typename... Args>
+            requires Consumer<F, T, Args...>
+        std::future<TaskStatus> loopConsumer(
+                Executor &executor, std::stop_source ss, F &&f, Args &&...args);
+
+        template <typename F, typename... Args>
+            requires(!Consumer<F, T, Args...>) && BatchConsumer<F, T, Args...>
+        std::future<TaskStatus> loopConsumer(
+                Executor &executor, std::stop_source ss, F &&f, Args &&...args) {
+            return loopConsumer(
+                    executor, ss, BatchOptions{}, std::forward<F>(f),
+                    std::forward<Args>(args)...);
+        }
+
+        template <typename F, typename... Args>
+            requires BatchConsumer<F, T, Args...>
+        std::future<TaskStatus> loopConsumer(
+                Executor &executor, std::stop_source ss, const BatchOptions &options, F &&f,
+                Args &&...args);
+        /// @}
+
+        /**
+         * @brief Call a function once the queue contains an element
+         *
+         * If the queue is already non-empty the callback is called immediately, otherwise it is
+         * called by the next push, while the lock is held. The callback must therefore be short
+         * and must not access the queue.
+         */
+        void onElementReady(std::function<void()> callback);
 #endif
     private:
-        std::queue<T> m_queue;
+        /// @brief Push a single value, waitForSpace is called if the policy is to block
+        template <typename U, typename Wait>
+        bool emplace(U &&value, const lock_t &lock, Wait &&waitForSpace);
+        /// @brief Push a range of values, waitForSpace is called if the policy is to block
+        template <typename It, typename S, typename Wait>
+        std::size_t emplaceRange(It first, S last, const lock_t &lock, Wait &&waitForSpace);
+        /// @brief Apply the overflow policy, returns false if value should be discarded
+        template <typename Wait>
+        bool admit(const T &value, const lock_t &lock, Wait &&waitForSpace);
+        /// @brief Block until there is space in the queue
+        bool waitForSpace(const lock_t &lock);
+#ifdef AsyncQueue_MULTITHREAD
+        /// @brief Block until there is space in the queue or st is stopped
+        bool waitForSpace(const lock_t &lock, std::stop_token st);
+        /// @brief Call the callbacks registered by onElementReady, the queue must not be empty
+        void runReadyCallbacks();
+#endif
+        /// @brief Is there space for another element?
+        bool hasSpace(const lock_t &lock) const;
+        /// @brief Wake producers waiting for space after extracting count elements
+        void notifyProducers(std::size_t count);
+        /// @brief Wake consumers after pushing count elements
+        void notifyConsumers(std::size_t count);
+        /// @brief Record that an element was pushed to the back of the queue
+        void recordPush();
+        /// @brief Record that the first count elements are about to be extracted
+        void recordPop(std::size_t count);
+
+        /// @brief An element in the queue, with the time it was pushed if instrumented
+        struct Entry {
+            template <typename U> explicit Entry(U &&value) : value(std::forward<U>(value)) {}
+            T value;
+#ifdef AsyncQueue_INSTRUMENT
+            std::chrono::steady_clock::time_point pushed{std::chrono::steady_clock::now()};
+#endif
+        };
+
+        std::deque<Entry> m_queue;
         mutable std::mutex m_mutex;
         std::condition_variable_any m_cv;
+        std::condition_variable_any m_notFull;
+        std::size_t m_capacity{0};
+        OverflowPolicy m_policy{OverflowPolicy::Block};
+        MessageLevel m_dropLevel{};
+        DropCounts m_dropCounts;
+        std::size_t m_blockedProducers{0};
+#ifdef AsyncQueue_MULTITHREAD
+        std::vector<std::function<void()>> m_readyCallbacks;
+#endif
+#ifdef AsyncQueue_INSTRUMENT
+        /// @brief Modified by @ref lock, so mutable
+        mutable QueueStats m_stats;
+#endif
     }; //> end class AsyncQueue<T>
 } // namespace AsyncQueue
 
@@ -1,40 +1,222 @@
+#include <algorithm>
 #include <cassert>
 
 namespace AsyncQueue {
     template <typename T> std::mutex &AsyncQueue<T>::mutex() const { return m_mutex; }
 
     template <typename T> typename AsyncQueue<T>::lock_t AsyncQueue<T>::lock() const {
+#ifdef AsyncQueue_INSTRUMENT
+        lock_t lock_(m_mutex, std::try_to_lock);
+        if (!lock_.owns_lock()) {
+            lock_.lock();
+            ++m_stats.contended;
+        }
+        return lock_;
+#else
         return lock_t(m_mutex);
+#endif
     }
 
     template <typename T> std::condition_variable_any &AsyncQueue<T>::cv() { return m_cv; }
 
-    template <typename T> void AsyncQueue<T>::push(const T &value) { push(value, lock()); }
+    template <typename T>
+    void AsyncQueue<T>::setCapacity(std::size_t capacity, OverflowPolicy policy) {
+        auto lock_ = lock();
+        m_capacity = capacity;
+        m_policy = policy;
+        m_notFull.notify_all();
+    }
 
-    template <typename T> void AsyncQueue<T>::push(const T &value, const lock_t &lock) {
-        assert(lock.owns_lock() && lock.mutex() == &m_mutex);
-        m_queue.push(value);
-        m_cv.notify_one();
+    template <typename T>
+    void AsyncQueue<T>::setCapacity(std::size_t capacity, MessageLevel dropBelow)
+        requires concepts::HasMessageLevel<T>
+    {
+        auto lock_ = lock();
+        m_capacity = capacity;
+        m_policy = OverflowPolicy::DropBelowLevel;
+        m_dropLevel = dropBelow;
+        m_notFull.notify_all();
     }
 
-    template <typename T> void AsyncQueue<T>::push(T &&value) { push(std::move(value), lock()); }
+    template <typename T> std::size_t AsyncQueue<T>::capacity() const {
+        auto lock_ = lock();
+        return m_capacity;
+    }
 
-    template <typename T> void AsyncQueue<T>::push(T &&value, const lock_t &lock) {
-        assert(lock.owns_lock() && lock.mutex() == &m_mutex);
-        m_queue.push(std::move(value));
-        m_cv.notify_one();
+    template <typename T> OverflowPolicy AsyncQueue<T>::overflowPolicy() const {
+        auto lock_ = lock();
+        return m_policy;
+    }
+
+    template <typename T> DropCounts AsyncQueue<T>::dropCounts() const {
+        auto lock_ = lock();
+        return m_dropCounts;
+    }
+
+    template <typename T> QueueStats AsyncQueue<T>::stats() const {
+#ifdef AsyncQueue_INSTRUMENT
+        // Don't use lock so that reading the statistics does not count as contention
+        lock_t lock_(m_mutex);
+        return m_stats;
+#else
+        return {};
+#endif
+    }
+
+    template <typename T> bool AsyncQueue<T>::push(const T &value) {
+        auto lock_ = lock();
+        return push(value, lock_);
+    }
+
+    template <typename T> bool AsyncQueue<T>::push(const T &value, const lock_t &lock) {
+        return emplace(value, lock, [this](const lock_t &l) { return waitForSpace(l); });
+    }
+
+    template <typename T> bool AsyncQueue<T>::push(T &&value) {
+        auto lock_ = lock();
+        return push(std::move(value), lock_);
+    }
+
+    template <typename T> bool AsyncQueue<T>::push(T &&value, const lock_t &lock) {
+        return emplace(std::move(value), lock, [this](const lock_t &l) { return waitForSpace(l); });
+    }
+
+#ifdef AsyncQueue_MULTITHREAD
+    template <typename T> bool AsyncQueue<T>::push(const T &value, std::stop_token st) {
+        auto lock_ = lock();
+        return push(value, lock_, st);
+    }
+
+    template <typename T>
+    bool AsyncQueue<T>::push(const T &value, const lock_t &lock, std::stop_token st) {
+        return emplace(value, lock, [this, &st](const lock_t &l) { return waitForSpace(l, st); });
     }
 
+    template <typename T> bool AsyncQueue<T>::push(T &&value, std::stop_token st) {
+        auto lock_ = lock();
+        return push(std::move(value), lock_, st);
+    }
+
+    template <typename T>
+    bool AsyncQueue<T>::push(T &&value, const lock_t &lock, std::stop_token st) {
+        return emplace(std::move(value), lock, [this, &st](const lock_t &l) {
+            return waitForSpace(l, st);
+        });
+    }
+#endif
+
+    template <typename T>
+    template <std::input_iterator It, std::sentinel_for<It> S>
+    std::size_t AsyncQueue<T>::pushRange(It first, S last) {
+        auto lock_ = lock();
+        return pushRange(std::move(first), std::move(last), lock_);
+    }
+
+    template <typename T>
+    template <std::input_iterator It, std::sentinel_for<It> S>
+    std::size_t AsyncQueue<T>::pushRange(It first, S last, const lock_t &lock) {
+        return emplaceRange(
+                std::move(first), std::move(last), lock,
+                [this](const lock_t &l) { return waitForSpace(l); });
+    }
+
+    template <typename T>
+    template <std::ranges::input_range R>
+    std::size_t AsyncQueue<T>::pushRange(R &&range) {
+        return pushRange(std::ranges::begin(range), std::ranges::end(range));
+    }
+
+    template <typename T>
+    template <std::ranges::input_range R>
+    std::size_t AsyncQueue<T>::pushRange(R &&range, const lock_t &lock) {
+        return pushRange(std::ranges::begin(range), std::ranges::end(range), lock);
+    }
+
+    template <typename T> std::size_t AsyncQueue<T>::pushBulk(std::vector<T> &&values) {
+        auto lock_ = lock();
+        return pushBulk(std::move(values), lock_);
+    }
+
+    template <typename T>
+    std::size_t AsyncQueue<T>::pushBulk(std::vector<T> &&values, const lock_t &lock) {
+        std::size_t count = pushRange(
+                std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()),
+                lock);
+        values.clear();
+        return count;
+    }
+
+#ifdef AsyncQueue_MULTITHREAD
+    template <typename T>
+    template <std::input_iterator It, std::sentinel_for<It> S>
+    std::size_t AsyncQueue<T>::pushRange(It first, S last, std::stop_token st) {
+        auto lock_ = lock();
+        return pushRange(std::move(first), std::move(last), lock_, st);
+    }
+
+    template <typename T>
+    template <std::input_iterator It, std::sentinel_for<It> S>
+    std::size_t AsyncQueue<T>::pushRange(It first, S last, const lock_t &lock, std::stop_token st) {
+        return emplaceRange(
+                std::move(first), std::move(last), lock,
+                [this, &st](const lock_t &l) { return waitForSpace(l, st); });
+    }
+
+    template <typename T>
+    std::size_t AsyncQueue<T>::pushBulk(std::vector<T> &&values, std::stop_token st) {
+        std::size_t count = pushRange(
+                std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()),
+                st);
+        values.clear();
+        return count;
+    }
+#endif
+
     template <typename T> std::optional<T> AsyncQueue<T>::extract() { return extract(lock()); }
 
     template <typename T> std::optional<T> AsyncQueue<T>::extract(const lock_t &lock) {
         if (empty(lock))
             return std::nullopt;
-        T value = std::move(m_queue.front());
-        m_queue.pop();
+        recordPop(1);
+        T value = std::move(m_queue.front().value);
+        m_queue.pop_front();
+        notifyProducers(1);
         return std::move(value);
     }
 
+    template <typename T>
+    std::size_t AsyncQueue<T>::extractBatch(std::vector<T> &out, std::size_t maxCount) {
+        return extractBatch(out, maxCount, lock());
+    }
+
+    template <typename T>
+    std::size_t AsyncQueue<T>::extractBatch(
+            std::vector<T> &out, std::size_t maxCount, [[maybe_unused]] const lock_t &lock) {
+        assert(lock.owns_lock() && lock.mutex() == &m_mutex);
+        std::size_t count = std::min(maxCount, m_queue.size());
+        recordPop(count);
+        for (std::size_t idx = 0; idx < count; ++idx) {
+            out.push_back(std::move(m_queue.front().value));
+            m_queue.pop_front();
+        }
+        notifyProducers(count);
+        return count;
+    }
+
+    template <typename T> void AsyncQueue<T>::requeue(std::span<T> values) {
+        if (values.empty())
+            return;
+        auto lock_ = lock();
+        for (auto itr = values.rbegin(); itr != values.rend(); ++itr)
+            m_queue.emplace_front(std::move(*itr));
+#ifdef AsyncQueue_INSTRUMENT
+        // They are counted again when they are next extracted
+        m_stats.dequeued -= values.size();
+        m_stats.highWaterMark = std::max(m_stats.highWaterMark, m_queue.size());
+#endif
+        notifyConsumers(values.size());
+    }
+
     template <typename T> std::size_t AsyncQueue<T>::size() const { return size(lock()); }
 
     template <typename T> std::size_t AsyncQueue<T>::size(const lock_t &) const {
@@ -47,7 +229,171 @@ namespace AsyncQueue {
         return m_queue.empty();
     }
 
+    template <typename T>
+    template <typename U, typename Wait>
+    bool AsyncQueue<T>::emplace(U &&value, const lock_t &lock, Wait &&waitForSpace) {
+        assert(lock.owns_lock() && lock.mutex() == &m_mutex);
+        if (!admit(value, lock, waitForSpace))
+            return false;
+        m_queue.emplace_back(std::forward<U>(value));
+        recordPush();
+        notifyConsumers(1);
+        return true;
+    }
+
+    template <typename T>
+    template <typename It, typename S, typename Wait>
+    std::size_t AsyncQueue<T>::emplaceRange(
+            It first, S last, const lock_t &lock, Wait &&waitForSpace) {
+        assert(lock.owns_lock() && lock.mutex() == &m_mutex);
+        std::size_t count = 0;
+        for (; first != last; ++first) {
+            // Dereferencing a move iterator yields an rvalue so only do it once
+            decltype(auto) value = *first;
+            if (!admit(value, lock, waitForSpace))
+                continue;
+            m_queue.emplace_back(std::forward<decltype(value)>(value));
+            recordPush();
+            ++count;
+        }
+        notifyConsumers(count);
+        return count;
+    }
+
+    template <typename T>
+    template <typename Wait>
+    bool AsyncQueue<T>::admit(
+            const T &value, const lock_t &lock, [[maybe_unused]] Wait &&waitForSpace) {
+        if (hasSpace(lock))
+            return true;
+        switch (m_policy) {
+        case OverflowPolicy::DropNewest:
+            ++m_dropCounts.newest;
+            return false;
+        case OverflowPolicy::DropOldest:
+            while (!hasSpace(lock)) {
+                m_queue.pop_front();
+                ++m_dropCounts.oldest;
+            }
+            return true;
+        case OverflowPolicy::DropBelowLevel:
+            if constexpr (concepts::HasMessageLevel<T>) {
+                if (value.level < m_dropLevel) {
+                    ++m_dropCounts.belowLevel;
+                    return false;
+                }
+            }
+            break;
+        case OverflowPolicy::Block:
+            break;
+        }
+#ifdef AsyncQueue_MULTITHREAD
+        if (waitForSpace(lock))
+            return true;
+        ++m_dropCounts.interrupted;
+#else
+        // There are no other threads to make space so blocking would never return
+        ++m_dropCounts.newest;
+#endif
+        return false;
+    }
+
+    template <typename T> bool AsyncQueue<T>::waitForSpace(const lock_t &lock) {
+        // Make sure that the consumers are awake to make the space. A bulk push only notifies them
+        // at the end so elements pushed so far may not have woken anyone yet
+        m_cv.notify_all();
+#ifdef AsyncQueue_MULTITHREAD
+        runReadyCallbacks();
+#endif
+        ++m_blockedProducers;
+        // Wait on the mutex itself as the lock is const. It still owns the mutex afterwards
+        m_notFull.wait(m_mutex, [this, &lock]() { return hasSpace(lock); });
+        --m_blockedProducers;
+        return true;
+    }
+
+    template <typename T> bool AsyncQueue<T>::hasSpace(const lock_t &lock) const {
+        return m_capacity == 0 || size(lock) < m_capacity;
+    }
+
+    template <typename T> void AsyncQueue<T>::notifyProducers(std::size_t count) {
+        if (m_blockedProducers == 0 || count == 0)
+            return;
+        if (count == 1)
+            m_notFull.notify_one();
+        else
+            m_notFull.notify_all();
+    }
+
+    template <typename T> void AsyncQueue<T>::notifyConsumers(std::size_t count) {
+        if (count == 0)
+            return;
+        if (count == 1)
+            m_cv.notify_one();
+        else
+            m_cv.notify_all();
+#ifdef AsyncQueue_MULTITHREAD
+        runReadyCallbacks();
+#endif
+    }
+
+    template <typename T> void AsyncQueue<T>::recordPush() {
+#ifdef AsyncQueue_INSTRUMENT
+        ++m_stats.enqueued;
+        m_stats.highWaterMark = std::max(m_stats.highWaterMark, m_queue.size());
+#endif
+    }
+
+    template <typename T> void AsyncQueue<T>::recordPop([[maybe_unused]] std::size_t count) {
+#ifdef AsyncQueue_INSTRUMENT
+        if (count == 0)
+            return;
+        auto now = std::chrono::steady_clock::now();
+        for (std::size_t idx = 0; idx < count; ++idx)
+            m_stats.latency.record(now - m_queue[idx].pushed);
+        m_stats.dequeued += count;
+#endif
+    }
+
 #ifdef AsyncQueue_MULTITHREAD
+    template <typename T> void AsyncQueue<T>::runReadyCallbacks() {
+        if (m_readyCallbacks.empty())
+            return;
+        auto callbacks = std::move(m_readyCallbacks);
+        m_readyCallbacks.clear();
+        for (auto &callback : callbacks)
+            callback();
+    }
+
+    template <typename T> bool AsyncQueue<T>::waitForElement(std::stop_token st) {
+        auto lock_ = lock();
+        return waitForElement(st, lock_);
+    }
+
+    template <typename T> bool AsyncQueue<T>::waitForElement(std::stop_token st, lock_t &lock) {
+        assert(lock.owns_lock() && lock.mutex() == &m_mutex);
+        return m_cv.wait(lock, st, [this, &lock]() { return !empty(lock); });
+    }
+
+    template <typename T>
+    bool AsyncQueue<T>::waitForSpace(const lock_t &lock, std::stop_token st) {
+        m_cv.notify_all();
+        runReadyCallbacks();
+        ++m_blockedProducers;
+        bool ready = m_notFull.wait(m_mutex, st, [this, &lock]() { return hasSpace(lock); });
+        --m_blockedProducers;
+        return ready;
+    }
+
+    template <typename T>
+    bool AsyncQueue<T>::waitForElements(
+            std::stop_token st, std::size_t count,
+            const std::chrono::steady_clock::time_point &deadline) {
+        auto lock_ = lock();
+        return m_cv.wait_until(
+                lock_, st, deadline, [this, &lock_, count]() { return size(lock_) >= count; });
+    }
+
     template <typename T>
     template <typename F, typename... Args>
         requires Consumer<F, T, Args...>
@@ -83,11 +429,69 @@ namespace AsyncQueue {
                             }
                             lock_.lock();
                         }
-                        this->cv().wait(lock_, st, [this]() { return true; });
+                        this->waitForElement(st, lock_);
                     }
                     return TaskStatus::CONTINUE;
                 },
                 ss, std::forward<F>(f), std::forward<Args>(args)...);
     }
+
+    template <typename T>
+    template <typename F, typename... Args>
+        requires BatchConsumer<F, T, Args...>
+    std::future<TaskStatus> AsyncQueue<T>::loopConsumer(
+            std::stop_source ss, const BatchOptions &options, F &&f, Args &&...args) {
+        return std::async(
+                std::launch::async,
+                [this](std::stop_source ss, BatchOptions options, F &&f, Args &&...args) {
+                    return detail::consumeBatches(
+                            *this, ss, options, [&f, &args...](std::span<const T> batch) {
+                                return std::invoke(f, batch, args...);
+                            });
+                },
+                ss, options, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    template <typename F, typename... Args>
+        requires Consumer<F, T, Args...>
+    std::future<TaskStatus> AsyncQueue<T>::loopConsumer(
+            Executor &executor, std::stop_source ss, F &&f, Args &&...args) {
+        auto consume = [f = std::forward<F>(f),
+                        ... args = std::forward<Args>(args)](std::span<const T> batch) mutable {
+            for (const T &element : batch)
+                if (TaskStatus status = std::invoke(f, element, args...);
+                    status != TaskStatus::CONTINUE)
+                    return status;
+            return TaskStatus::CONTINUE;
+        };
+        return detail::ExecutorConsumer<AsyncQueue, decltype(consume)>::start(
+                executor, *this, ss, BatchOptions{1}, std::move(consume));
+    }
+
+    template <typename T>
+    template <typename F, typename... Args>
+        requires BatchConsumer<F, T, Args...>
+    std::future<TaskStatus> AsyncQueue<T>::loopConsumer(
+            Executor &executor, std::stop_source ss, const BatchOptions &options, F &&f,
+            Args &&...args) {
+        auto consume = [f = std::forward<F>(f),
+                        ... args = std::forward<Args>(args)](std::span<const T> batch) mutable {
+            return std::invoke(f, batch, args...);
+        };
+        return detail::ExecutorConsumer<AsyncQueue, decltype(consume)>::start(
+                executor, *this, ss, options, std::move(consume));
+    }
+
+    template <typename T> void AsyncQueue<T>::onElementReady(std::function<void()> callback) {
+        {
+            auto lock_ = lock();
+            if (empty(lock_)) {
+                m_readyCallbacks.push_back(std::move(callback));
+                return;
+            }
+        }
+        callback();
+    }
 #endif
-} // namespace AsyncQueue
\ No newline at end of file
+} // namespace AsyncQueue
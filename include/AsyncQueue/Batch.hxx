@@ -0,0 +1,59 @@
+/**
+ * @file Batch.hxx
+ * @brief Options and helpers for consuming queue elements in batches
+ */
+
+#ifndef ASYNCQUEUE_BATCH_HXX
+#define ASYNCQUEUE_BATCH_HXX
+
+#include "AsyncQueue/TaskStatus.hxx"
+
+#include <chrono>
+#include <cstddef>
+
+#ifdef AsyncQueue_MULTITHREAD
+#include <stop_token>
+#endif
+
+namespace AsyncQueue {
+    /// @brief Describes how queue elements are grouped before being passed to a batch consumer
+    struct BatchOptions {
+        /// @brief The maximum number of elements passed to the consumer in a single call
+        std::size_t maxSize{1024};
+        /// @brief How long to wait for a partial batch to fill up before consuming it
+        ///
+        /// The wait only begins once at least one element is available. A value of zero means
+        /// that whatever is in the queue is consumed immediately.
+        std::chrono::steady_clock::duration maxLinger{std::chrono::steady_clock::duration::zero()};
+    };
+
+#ifdef AsyncQueue_MULTITHREAD
+    namespace detail {
+        /**
+         * @brief Repeatedly drain a queue in batches and pass them to a function
+         * @tparam Queue The queue type, which must provide waitForElement, waitForElements and
+         *               extractBatch
+         * @tparam F Function taking a std::span of the queue's elements and returning a TaskStatus.
+         *           The batch is discarded afterwards so it may move elements out of the span
+         * @param queue The queue to drain
+         * @param ss The stop source controlling execution
+         * @param options How to group the elements
+         * @param f The function to call on each batch
+         * @return TaskStatus::CONTINUE if the loop ended because a stop was requested, otherwise
+         *         the status returned by the function
+         *
+         * If the function throws an exception stop is requested on the source and the exception
+         * is rethrown. If it returns TaskStatus::ABORT stop is requested on the source.
+         */
+        template <typename Queue, typename F>
+        TaskStatus consumeBatches(
+                Queue &queue, std::stop_source ss, const BatchOptions &options, F &&f);
+    } // namespace detail
+#endif
+} // namespace AsyncQueue
+
+#ifdef AsyncQueue_MULTITHREAD
+#include "AsyncQueue/Batch.ixx"
+#endif
+
+#endif //> !ASYNCQUEUE_BATCH_HXX
@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <span>
+#include <vector>
+
+namespace AsyncQueue::detail {
+    template <typename Queue, typename F>
+    TaskStatus consumeBatches(
+            Queue &queue, std::stop_source ss, const BatchOptions &options, F &&f) {
+        using value_t = typename Queue::value_type;
+        const std::size_t maxSize = std::max<std::size_t>(options.maxSize, 1);
+        auto st = ss.get_token();
+        std::vector<value_t> batch;
+        batch.reserve(maxSize);
+        while (!st.stop_requested()) {
+            if (!queue.waitForElement(st))
+                continue;
+            if (options.maxLinger > options.maxLinger.zero())
+                queue.waitForElements(
+                        st, maxSize, std::chrono::steady_clock::now() + options.maxLinger);
+            while (queue.extractBatch(batch, maxSize) > 0) {
+                TaskStatus status{TaskStatus::CONTINUE};
+                try {
+                    status = f(std::span<value_t>(batch));
+                } catch (...) {
+                    ss.request_stop();
+                    throw;
+                }
+                batch.clear();
+
+                switch (status) {
+                case TaskStatus::CONTINUE:
+                    break;
+                case TaskStatus::HALT:
+                    return TaskStatus::HALT;
+                case TaskStatus::ABORT:
+                    ss.request_stop();
+                    return TaskStatus::ABORT;
+                }
+            }
+        }
+        return TaskStatus::CONTINUE;
+    }
+} // namespace AsyncQueue::detail
@@ -0,0 +1,113 @@
+/**
+ * @file BinaryLog.hxx
+ * @brief The binary log segment format and a memory-mapped reader for it
+ *
+ * A binary log is a series of segment files named "<prefix>.<index>.aqlog", written by the
+ * BinaryMessageWriter. Each segment is self-contained and starts with a 16 byte header: the magic
+ * string "AQBINLOG", a 32-bit format version and a 32-bit byte order mark. The header is followed
+ * by records, all in the writer's native byte order:
+ *
+ * - Source: type (1 byte), 3 padding bytes, 32-bit source index, 32-bit name length, the name.
+ *   Assigns the next index in the segment's source dictionary, before the index is first used.
+ * - Message: type (1 byte), level (1 byte), 2 padding bytes, 32-bit source index, 64-bit time in
+ *   nanoseconds since the system clock epoch, 32-bit text length, the text.
+ *
+ * A segment whose final record is incomplete, for example because the writer was interrupted, is
+ * read up to the end of the last complete record.
+ */
+
+#ifndef ASYNCQUEUE_BINARYLOG_HXX
+#define ASYNCQUEUE_BINARYLOG_HXX
+
+#include "AsyncQueue/Message.hxx"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace AsyncQueue {
+    namespace detail {
+        /// @brief The extension of segment files
+        constexpr inline std::string_view binaryLogExtension{".aqlog"};
+        /// @brief The magic string at the start of each segment
+        constexpr inline std::string_view binaryLogMagic{"AQBINLOG"};
+        /// @brief The current version of the segment format
+        constexpr inline std::uint32_t binaryLogVersion = 1;
+        /// @brief Written in native byte order to detect segments from a different platform
+        constexpr inline std::uint32_t binaryLogByteOrder = 0x01020304;
+        /// @brief The size of the segment header
+        constexpr inline std::size_t binaryLogHeaderSize = 16;
+        /// @brief The size of a source record, excluding the name
+        constexpr inline std::size_t binaryLogSourceSize = 12;
+        /// @brief The size of a message record, excluding the text
+        constexpr inline std::size_t binaryLogMessageSize = 20;
+
+        /// @brief The type of a record, its first byte
+        enum class BinaryRecordType : std::uint8_t { Source = 1, Message = 2 };
+    } // namespace detail
+
+    /// @brief The path of a segment
+    /// @param prefix The path prefix shared by all segments of the log
+    /// @param index The index of the segment
+    std::string binaryLogSegmentPath(const std::string &prefix, std::size_t index);
+
+    /// @brief Find the existing segments of a log, in index order
+    /// @param prefix The path prefix shared by all segments of the log
+    std::vector<std::string> findBinaryLogSegments(const std::string &prefix);
+
+    /// @brief A message read from a segment, which refers to the segment's memory
+    struct BinaryLogRecord {
+        std::string_view source;
+        std::chrono::time_point<std::chrono::system_clock> time;
+        MessageLevel level;
+        std::string_view text;
+
+        /// @brief Copy the record into a message, e.g. to pass it to a formatter. The source name
+        ///        is interned in the SourceRegistry, or copied if it is full, so the message
+        ///        outlives the segment
+        Message toMessage() const;
+    };
+
+    /**
+     * @brief A segment file mapped into memory
+     *
+     * Records are decoded in place. Only the fixed size part of each message is read before it
+     * is passed to the caller, so filtering records does not touch their text.
+     */
+    class BinaryLogSegment {
+    public:
+        /// @brief Map the segment
+        /// @param path The segment file
+        ///
+        /// Throws std::system_error if the file cannot be mapped and std::runtime_error if it is
+        /// not a segment of a supported version.
+        explicit BinaryLogSegment(const std::string &path);
+        BinaryLogSegment(const BinaryLogSegment &) = delete;
+        BinaryLogSegment &operator=(const BinaryLogSegment &) = delete;
+        ~BinaryLogSegment();
+
+        /// @brief Call a function with each message in the segment, in the order written
+        /// @tparam F Callable with a const BinaryLogRecord &
+        template <typename F> void forEach(F &&f) const;
+
+        /// @brief The size of the mapped file
+        std::size_t size() const { return m_size; }
+
+    private:
+        /// @brief Decode the record at offset, adding any source to the dictionary
+        /// @return False if there are no more complete records
+        bool next(
+                std::size_t &offset, BinaryLogRecord &record, bool &isMessage,
+                std::vector<std::string_view> &sources) const;
+
+        const char *m_data{nullptr};
+        std::size_t m_size{0};
+    };
+} // namespace AsyncQueue
+
+#include "AsyncQueue/BinaryLog.ixx"
+
+#endif //> !ASYNCQUEUE_BINARYLOG_HXX
@@ -0,0 +1,11 @@
+namespace AsyncQueue {
+    template <typename F> void BinaryLogSegment::forEach(F &&f) const {
+        std::vector<std::string_view> sources;
+        BinaryLogRecord record;
+        bool isMessage = false;
+        std::size_t offset = detail::binaryLogHeaderSize;
+        while (next(offset, record, isMessage, sources))
+            if (isMessage)
+                f(static_cast<const BinaryLogRecord &>(record));
+    }
+} // namespace AsyncQueue
@@ -0,0 +1,78 @@
+#ifndef ASYNCQUEUE_BINARYMESSAGEWRITER_HXX
+#define ASYNCQUEUE_BINARYMESSAGEWRITER_HXX
+
+#include "AsyncQueue/BinaryLog.hxx"
+#include "AsyncQueue/IBatchConsumer.hxx"
+#include "AsyncQueue/Message.hxx"
+#include "AsyncQueue/SourceRegistry.hxx"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace AsyncQueue {
+    /**
+     * @brief Message writer that records messages in the binary log format
+     *
+     * Messages are stored without formatting, see BinaryLog.hxx for the layout. Each batch is
+     * encoded into a buffer and appended to the current segment with a single write. A new
+     * segment is started, with an empty source dictionary, once the current one has reached the
+     * maximum size, so a segment exceeds it by at most one batch. Existing segments are never
+     * appended to: the writer starts after the highest existing index.
+     *
+     * If a batch cannot be written its messages are dropped and the next batch starts a new
+     * segment, as the current one may end with an incomplete record.
+     */
+    class BinaryMessageWriter : public IBatchConsumer<Message> {
+    public:
+        /// @brief Create the writer
+        /// @param prefix The path prefix of the segment files
+        /// @param lvl Only write messages at or above this level
+        /// @param maxSegmentSize Start a new segment once the current one reaches this size
+        ///
+        /// Throws std::system_error if the first segment cannot be created.
+        BinaryMessageWriter(
+                const std::string &prefix, MessageLevel lvl = MessageLevel::VERBOSE,
+                std::size_t maxSegmentSize = 64 << 20);
+        ~BinaryMessageWriter();
+
+        using IBatchConsumer<Message>::consume;
+        TaskStatus consume(std::span<const Message> messages) override;
+
+        /// @brief The path of the current segment
+        std::string segmentPath() const { return binaryLogSegmentPath(m_prefix, m_index); }
+
+        /// @brief The number of messages dropped because they could not be written
+        std::size_t droppedMessages() const { return m_nDropped; }
+
+    private:
+        /// @brief Close the current segment and start the next
+        /// @return False if the new segment could not be created
+        bool openSegment();
+        /// @brief The index of the message's source in the current segment's dictionary
+        std::uint32_t segmentSource(const Message &message);
+        /// @brief Add a name to the current segment's dictionary, returning its index + 1
+        std::uint32_t addSegmentSource(std::string_view name);
+
+        const std::string m_prefix;
+        const MessageLevel m_lvl;
+        const std::size_t m_maxSegmentSize;
+        std::size_t m_index{0};
+        int m_fd{-1};
+        std::size_t m_segmentSize{0};
+        /// @brief The encoded records of the current batch
+        std::string m_buffer;
+        /// @brief Segment dictionary index + 1 for each SourceId, or 0 if not yet in the segment
+        std::vector<std::uint32_t> m_segmentSources;
+        /// @brief Segment dictionary index + 1 for each name which isn't in the SourceRegistry
+        std::unordered_map<std::string, std::uint32_t> m_segmentUninterned;
+        std::uint32_t m_nSegmentSources{0};
+        std::size_t m_nDropped{0};
+    };
+} // namespace AsyncQueue
+
+#endif //> !ASYNCQUEUE_BINARYMESSAGEWRITER_HXX
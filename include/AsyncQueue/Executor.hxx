@@ -0,0 +1,169 @@
+/**
+ * @file Executor.hxx
+ * @brief Shared thread pool on which looping tasks and queue consumers can run
+ */
+
+#ifdef AsyncQueue_MULTITHREAD
+#ifndef ASYNCQUEUE_EXECUTOR_HXX
+#define ASYNCQUEUE_EXECUTOR_HXX
+
+#include "AsyncQueue/Batch.hxx"
+#include "AsyncQueue/TaskStatus.hxx"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace AsyncQueue {
+    /**
+     * @brief Work-stealing thread pool with a shared timer
+     *
+     * Each pool thread owns a deque of tasks. Tasks submitted from a pool thread go onto that
+     * thread's deque, other tasks are distributed round-robin. A thread runs the tasks on its own
+     * deque in order and, when it runs out, steals from the back of the others' deques before
+     * going to sleep.
+     *
+     * Delayed tasks are held in a hashed timer wheel serviced by a single timer thread, which
+     * submits each task to the pool at the first tick on or after its deadline. The timer thread
+     * sleeps until the tick on which the earliest pending task is due.
+     *
+     * Tasks should not block. The executor overloads of loop, setTimeout and loopConsumer, and the
+     * ManagedQueue executor constructors, reschedule themselves between iterations rather than
+     * occupying a thread. Tasks must not throw. Any tasks that have not run when the executor is
+     * destroyed are discarded (breaking the promise of any loop running on it) so all work using
+     * the executor should be stopped first.
+     */
+    class Executor {
+    public:
+        using task_t = std::function<void()>;
+        using clock_t = std::chrono::steady_clock;
+
+        /**
+         * @brief Create the executor and start its threads
+         * @param nThreads The number of pool threads. If 0 the hardware concurrency is used
+         * @param tick The resolution of the timer wheel
+         * @param wheelSize The number of slots in the timer wheel
+         */
+        explicit Executor(
+                std::size_t nThreads = 0, clock_t::duration tick = std::chrono::milliseconds(1),
+                std::size_t wheelSize = 512);
+        ~Executor();
+        Executor(const Executor &) = delete;
+        Executor &operator=(const Executor &) = delete;
+
+        /// @brief The number of pool threads
+        std::size_t size() const { return m_workers.size(); }
+
+        /// @brief Queue a task to run as soon as a thread is available
+        void submit(task_t task);
+
+        /// @brief Queue a task to run once the deadline has passed
+        void schedule(clock_t::time_point deadline, task_t task);
+
+    private:
+        struct Worker {
+            std::mutex mutex;
+            std::deque<task_t> tasks;
+        };
+        struct Timer {
+            clock_t::time_point deadline;
+            task_t task;
+        };
+
+        void workerLoop(std::size_t index);
+        bool runNext(std::size_t index);
+        void timerLoop();
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::vector<std::thread> m_threads;
+        std::atomic<std::size_t> m_nextWorker{0};
+        std::atomic<std::size_t> m_pending{0};
+        std::atomic<std::size_t> m_idle{0};
+        std::atomic<bool> m_stopping{false};
+        std::mutex m_idleMutex;
+        std::condition_variable m_idleCv;
+
+        const clock_t::duration m_tick;
+        std::vector<std::vector<Timer>> m_wheel;
+        std::size_t m_cursor{0};
+        /// @brief The time corresponding to the slot at m_cursor
+        clock_t::time_point m_wheelTime;
+        std::size_t m_timerCount{0};
+        /// @brief The deadlines of the pending timers, earliest first
+        std::priority_queue<
+                clock_t::time_point, std::vector<clock_t::time_point>, std::greater<>>
+                m_deadlines;
+        std::mutex m_timerMutex;
+        std::condition_variable m_timerCv;
+        std::thread m_timerThread;
+    };
+
+    namespace detail {
+        /**
+         * @brief Queue consumer which runs as a sequence of tasks on an executor
+         * @tparam Queue The queue type, which must provide extractBatch, size and onElementReady
+         * @tparam F Function taking a std::span of the queue's elements and returning a TaskStatus.
+         *           The batch is discarded afterwards so it may move elements out of the span
+         *
+         * Each task consumes one batch and then resubmits itself. When the queue is empty it
+         * registers a callback with the queue so that the next push resumes it, and a stop request
+         * resumes it so that it can finish. The interaction of the return value with the stop
+         * source matches detail::consumeBatches.
+         */
+        template <typename Queue, typename F>
+        class ExecutorConsumer : public std::enable_shared_from_this<ExecutorConsumer<Queue, F>> {
+        public:
+            /**
+             * @brief Start consuming
+             * @param executor The executor to run on
+             * @param queue The queue to consume
+             * @param ss The stop source controlling execution
+             * @param options How to group the elements
+             * @param f The function to call on each batch
+             * @param drainOnStop If true remaining elements are consumed after a stop request
+             * @return A future containing the final result of the function
+             */
+            static std::future<TaskStatus> start(
+                    Executor &executor, Queue &queue, std::stop_source ss,
+                    const BatchOptions &options, F f, bool drainOnStop = false);
+
+            ExecutorConsumer(
+                    Executor &executor, Queue &queue, std::stop_source ss,
+                    const BatchOptions &options, F f, bool drainOnStop);
+
+        private:
+            using value_t = typename Queue::value_type;
+            void wake();
+            void run();
+            void finish();
+
+            Executor &m_executor;
+            Queue &m_queue;
+            std::stop_source m_ss;
+            BatchOptions m_options;
+            F m_f;
+            bool m_drainOnStop;
+            bool m_lingered{false};
+            std::atomic<bool> m_scheduled{true};
+            std::vector<value_t> m_batch;
+            std::promise<TaskStatus> m_promise;
+            std::optional<std::stop_callback<std::function<void()>>> m_stopCallback;
+        };
+    } // namespace detail
+} // namespace AsyncQueue
+
+#include "AsyncQueue/Executor.ixx"
+
+#endif //> !ASYNCQUEUE_EXECUTOR_HXX
+#endif //> AsyncQueue_MULTITHREAD
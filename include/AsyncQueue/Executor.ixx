@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <span>
+
+namespace AsyncQueue::detail {
+    template <typename Queue, typename F>
+    std::future<TaskStatus> ExecutorConsumer<Queue, F>::start(
+            Executor &executor, Queue &queue, std::stop_source ss, const BatchOptions &options,
+            F f, bool drainOnStop) {
+        auto consumer = std::make_shared<ExecutorConsumer>(
+                executor, queue, ss, options, std::move(f), drainOnStop);
+        auto future = consumer->m_promise.get_future();
+        // The callback only holds a weak reference so that it doesn't keep the consumer alive
+        // after it has finished
+        consumer->m_stopCallback.emplace(
+                ss.get_token(), [weak = std::weak_ptr<ExecutorConsumer>(consumer)]() {
+                    if (auto self = weak.lock())
+                        self->wake();
+                });
+        executor.submit([consumer]() { consumer->run(); });
+        return future;
+    }
+
+    template <typename Queue, typename F>
+    ExecutorConsumer<Queue, F>::ExecutorConsumer(
+            Executor &executor, Queue &queue, std::stop_source ss, const BatchOptions &options,
+            F f, bool drainOnStop)
+            : m_executor(executor), m_queue(queue), m_ss(ss), m_options(options),
+              m_f(std::move(f)), m_drainOnStop(drainOnStop) {
+        m_options.maxSize = std::max<std::size_t>(m_options.maxSize, 1);
+        m_batch.reserve(m_options.maxSize);
+    }
+
+    template <typename Queue, typename F> void ExecutorConsumer<Queue, F>::wake() {
+        // Only one run can be queued or executing at a time
+        if (!m_scheduled.exchange(true))
+            m_executor.submit([self = this->shared_from_this()]() { self->run(); });
+    }
+
+    template <typename Queue, typename F> void ExecutorConsumer<Queue, F>::run() {
+        auto st = m_ss.get_token();
+        bool stopping = st.stop_requested();
+        if (stopping && !m_drainOnStop) {
+            m_promise.set_value(TaskStatus::CONTINUE);
+            finish();
+            return;
+        }
+        if (!stopping && !m_lingered && m_options.maxLinger > m_options.maxLinger.zero() &&
+            !m_queue.empty() && m_queue.size() < m_options.maxSize) {
+            // Give a partial batch time to fill. A stop request during the wait is only noticed
+            // once it has elapsed
+            m_lingered = true;
+            m_executor.schedule(
+                    Executor::clock_t::now() + m_options.maxLinger,
+                    [self = this->shared_from_this()]() { self->run(); });
+            return;
+        }
+        m_lingered = false;
+
+        if (m_queue.extractBatch(m_batch, m_options.maxSize) > 0) {
+            TaskStatus status{TaskStatus::CONTINUE};
+            try {
+                status = m_f(std::span<value_t>(m_batch));
+            } catch (...) {
+                m_batch.clear();
+                m_ss.request_stop();
+                m_promise.set_exception(std::current_exception());
+                finish();
+                return;
+            }
+            m_batch.clear();
+
+            switch (status) {
+            case TaskStatus::CONTINUE:
+                // Go to the back of the line so that other tasks get a chance to run
+                m_executor.submit([self = this->shared_from_this()]() { self->run(); });
+                return;
+            case TaskStatus::HALT:
+                m_promise.set_value(TaskStatus::HALT);
+                finish();
+                return;
+            case TaskStatus::ABORT:
+                m_ss.request_stop();
+                m_promise.set_value(TaskStatus::ABORT);
+                finish();
+                return;
+            }
+        }
+
+        if (stopping) {
+            m_promise.set_value(TaskStatus::CONTINUE);
+            finish();
+            return;
+        }
+        // Park until the queue has an element or a stop is requested. If the stop callback ran
+        // while this task was still marked as scheduled it didn't resubmit it, so check again
+        m_scheduled.store(false);
+        if (st.stop_requested()) {
+            wake();
+            return;
+        }
+        m_queue.onElementReady([self = this->shared_from_this()]() { self->wake(); });
+    }
+
+    template <typename Queue, typename F> void ExecutorConsumer<Queue, F>::finish() {
+        // m_scheduled is left set so that any outstanding callbacks are ignored
+        m_stopCallback.reset();
+    }
+} // namespace AsyncQueue::detail
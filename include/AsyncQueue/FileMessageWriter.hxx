@@ -1,18 +1,78 @@
 #ifndef ASYNCQUEUE_FILEMESSAGEWRITER_HXX
 #define ASYNCQUEUE_FILEMESSAGEWRITER_HXX
 
+#include "AsyncQueue/Fwd.hxx"
+#include "AsyncQueue/IBatchConsumer.hxx"
+#include "AsyncQueue/Message.hxx"
+#include "AsyncQueue/MessageFormatter.hxx"
 #include "AsyncQueue/MessageWriter.hxx"
 
-#include <fstream>
+#include <chrono>
+#include <cstddef>
+#include <ios>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
 
 namespace AsyncQueue {
-    /// @brief Message writer that writes to an output file
-    class FileMessageWriter : public MessageWriter {
+    /// @brief Describes how a FileMessageWriter buffers, flushes and rotates its file
+    struct FileWriterOptions {
+        /// @brief The size of the buffer. It is written to the file when it would overflow
+        std::size_t bufferSize{1 << 20};
+        /// @brief The longest time that buffered text is held before being written
+        std::chrono::steady_clock::duration flushInterval{std::chrono::seconds(1)};
+        /// @brief Messages at or above this level are written to the file immediately
+        MessageLevel flushLevel{MessageLevel::ERROR};
+        /// @brief Rotate the file before it would grow beyond this size. Zero disables this
+        std::size_t maxFileSize{0};
+        /// @brief Rotate the file after it has been open for this long. Zero disables this
+        std::chrono::system_clock::duration rotateInterval{
+                std::chrono::system_clock::duration::zero()};
+        /// @brief The number of rotated files to keep. Zero keeps all of them
+        std::size_t maxRotatedFiles{0};
+        /// @brief Compress rotated files with gzip. Ignored if built without zlib
+        bool compress{false};
+#ifdef AsyncQueue_MULTITHREAD
+        /// @brief The executor which runs the flush timer and archives rotated files. It must
+        /// outlive the writer. If null a single thread executor shared by all writers is used
+        Executor *executor{nullptr};
+#endif
+    };
+
+    /**
+     * @brief Message writer that writes to an output file
+     *
+     * Formatted messages are collected in a buffer which is written directly to the file
+     * descriptor with write or writev, without going through a stream. The buffer is written when
+     * it is full, when a message at or above the flush level arrives, once the flush interval has
+     * passed and when the writer is destroyed. In multithreaded builds the flush interval is
+     * enforced by a task in the timer of an Executor, see FileWriterOptions::executor, otherwise
+     * it is checked as each batch arrives.
+     *
+     * The file can be rotated by size or age. Rotation happens between batches, so a single batch
+     * larger than the maximum size is written to one file. The current file is renamed to
+     * "<filename>.<UTC time>" and a new file opened. In multithreaded builds compressing the
+     * rotated file and removing old ones runs as a task on the executor, off the consumer thread.
+     * The destructor waits for this to finish.
+     *
+     * If the file cannot be written, for example because the disk is full, the text is kept in
+     * the buffer and retried at the next flush. If the buffer fills while the file is unwritable
+     * its contents are discarded. Once writing succeeds again a line reporting the number of
+     * discarded messages is written.
+     *
+     * Throws std::system_error if the file cannot be opened.
+     */
+    class FileMessageWriter : public IBatchConsumer<Message> {
     public:
+        using formatter_t = MessageWriter::formatter_t;
+
         /// @brief Create the writer
         /// @param filename The file to open
         /// @param lvl The minimum received message level to write
-        /// @param mode The mode with which to open the file
+        /// @param mode The mode with which to open the file, std::ios_base::app to append
         FileMessageWriter(
                 const std::string &filename, MessageLevel lvl = MessageLevel::VERBOSE,
                 std::ios_base::openmode mode = std::ios_base::trunc);
@@ -21,15 +81,125 @@ namespace AsyncQueue {
         /// @param filename The file to open
         /// @param formatter The formatter to use
         /// @param lvl The minimum received message level to write
-        /// @param mode The mode with which to open the file
+        /// @param mode The mode with which to open the file, std::ios_base::app to append
         FileMessageWriter(
                 const std::string &filename, formatter_t formatter,
                 MessageLevel lvl = MessageLevel::VERBOSE,
                 std::ios_base::openmode mode = std::ios_base::trunc);
 
+        /// @brief Create the writer
+        /// @param filename The file to open
+        /// @param formatter The formatter to use, which appends directly to the buffer
+        /// @param lvl The minimum received message level to write
+        /// @param mode The mode with which to open the file, std::ios_base::app to append
+        FileMessageWriter(
+                const std::string &filename, MessageFormatter formatter,
+                MessageLevel lvl = MessageLevel::VERBOSE,
+                std::ios_base::openmode mode = std::ios_base::trunc);
+
+        /// @brief Create the writer
+        /// @param filename The file to open
+        /// @param options How to buffer, flush and rotate the file
+        /// @param formatter The formatter to use, which appends directly to the buffer
+        /// @param lvl The minimum received message level to write
+        /// @param mode The mode with which to open the file, std::ios_base::app to append
+        FileMessageWriter(
+                const std::string &filename, const FileWriterOptions &options,
+                MessageFormatter formatter = MessageFormatter(),
+                MessageLevel lvl = MessageLevel::VERBOSE,
+                std::ios_base::openmode mode = std::ios_base::trunc);
+
+        /// @brief Create the writer
+        /// @param filename The file to open
+        /// @param options How to buffer, flush and rotate the file
+        /// @param formatter The formatter to use
+        /// @param lvl The minimum received message level to write
+        /// @param mode The mode with which to open the file, std::ios_base::app to append
+        FileMessageWriter(
+                const std::string &filename, const FileWriterOptions &options,
+                formatter_t formatter, MessageLevel lvl = MessageLevel::VERBOSE,
+                std::ios_base::openmode mode = std::ios_base::trunc);
+
+        /// @brief Write any buffered text and close the file, then wait for rotated files to be
+        ///        archived
+        ~FileMessageWriter();
+
+        using IBatchConsumer<Message>::consume;
+        TaskStatus consume(std::span<const Message> messages) override;
+
+        /// @brief Write any buffered text to the file
+        /// @return Whether all of the text was written
+        bool flush();
+
+        /// @brief The number of messages discarded because the file could not be written
+        std::size_t droppedMessages() const;
+
     private:
-        std::ofstream m_ofs;
+        /// @brief Compresses rotated files and removes the oldest ones
+        class Archiver;
+#ifdef AsyncQueue_MULTITHREAD
+        /// @brief Shared with the scheduled flush task so that it can outlive the writer
+        struct FlushTimer;
+#endif
+
+        FileMessageWriter(
+                const std::string &filename, const FileWriterOptions &options,
+                formatter_t format, std::optional<MessageFormatter> formatter, MessageLevel lvl,
+                std::ios_base::openmode mode);
+
+        /// @brief Open m_filename, returning false on failure
+        bool open(bool append);
+        /// @brief Write the buffer followed by extra in a single call where possible
+        /// @return Whether everything was written. Unwritten text is left in the buffer
+        bool write(std::string_view extra = {});
+        /// @brief Flush without taking the lock
+        bool flushUnlocked();
+        /// @brief Rotate the file if it is due, given that size more bytes are waiting
+        void rotateIfDue(std::size_t size);
+        /// @brief Close the file and move it aside, then open a new one
+        void rotate();
+        /// @brief Discard the buffer, counting its messages as dropped
+        void discard();
+#ifdef AsyncQueue_MULTITHREAD
+        /// @brief Schedule the next check of the flush interval
+        void scheduleFlush();
+        /// @brief Flush and rotate the file if they are due, then schedule the next check
+        void onFlushTimer();
+#endif
+
+#ifdef AsyncQueue_MULTITHREAD
+        /// @brief Runs the flush timer and archives rotated files
+        Executor &m_executor;
+#endif
+        const FileWriterOptions m_options;
+        const std::string m_filename;
+        const MessageLevel m_lvl;
+        formatter_t m_format;
+        std::optional<MessageFormatter> m_formatter;
+        mutable std::mutex m_mutex;
+        int m_fd{-1};
+        /// @brief Formatted text waiting to be written
+        std::string m_buffer;
+        /// @brief The number of messages in the buffer
+        std::size_t m_nBuffered{0};
+        /// @brief The formatted text of the current batch
+        std::string m_batch;
+        /// @brief The number of bytes written to the current file
+        std::size_t m_fileSize{0};
+        /// @brief Whether the last character written to the file was not a newline
+        bool m_lineOpen{false};
+        std::chrono::steady_clock::time_point m_lastFlush;
+        std::chrono::system_clock::time_point m_rotateAt;
+        /// @brief Messages discarded since the last successful write, not yet reported
+        std::size_t m_nUnreported{0};
+        std::size_t m_nDropped{0};
+        /// @brief The errno of the last failed write
+        int m_lastError{0};
+        std::shared_ptr<Archiver> m_archiver;
+#ifdef AsyncQueue_MULTITHREAD
+        std::shared_ptr<FlushTimer> m_flushTimer;
+#endif
     };
 } // namespace AsyncQueue
 
-#endif //> !ASYNCQUEUE_FILEMESSAGEWRITER_HXX
\ No newline at end of file
+#endif //> !ASYNCQUEUE_FILEMESSAGEWRITER_HXX
@@ -0,0 +1,99 @@
+/**
+ * @file Format.hxx
+ * @brief std::format style formatting of messages, deferred to the consumer thread
+ */
+
+#ifndef ASYNCQUEUE_FORMAT_HXX
+#define ASYNCQUEUE_FORMAT_HXX
+
+#include "AsyncQueue/Message.hxx"
+
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#if __has_include(<format>)
+#include <format>
+#endif
+
+namespace AsyncQueue {
+    /**
+     * @brief A format string checked at compile time against its arguments
+     * @tparam Args The types of the arguments
+     *
+     * Must be constructed from a constant expression, so the string is normally a literal and
+     * outlives any message created from it. The replacement fields are checked against the number
+     * of arguments. Fields are either all automatically numbered ("{}") or all manually numbered
+     * ("{0}"). "{{" and "}}" are literal braces.
+     */
+    template <typename... Args> class BasicFormatString {
+    public:
+        template <typename S>
+            requires std::convertible_to<const S &, std::string_view>
+        consteval BasicFormatString(const S &str);
+
+        /// @brief The format string
+        constexpr std::string_view get() const { return m_str; }
+
+    private:
+        std::string_view m_str;
+    };
+
+    /// @brief Format string type used by the formatting functions, mirrors std::format_string
+    template <typename... Args>
+    using FormatString = BasicFormatString<std::type_identity_t<Args>...>;
+
+    /**
+     * @brief Append formatted text to a string
+     * @param out The string to append to
+     * @param fmt The format string
+     * @param args The arguments to format
+     *
+     * Uses std::vformat_to if the standard library provides <format>. Otherwise each replacement
+     * field is substituted with the corresponding argument written by operator<<, and any format
+     * specification after a ':' in the field is ignored.
+     */
+    template <typename... Args>
+    void formatTo(std::string &out, std::string_view fmt, const Args &...args);
+
+    namespace detail {
+        /// @brief The type in which a format argument is captured
+        ///
+        /// Arguments are stored by value. Character pointers and string views are copied into
+        /// strings so that a captured argument never refers to the caller's storage.
+        template <typename T>
+        using capture_t = std::conditional_t<
+                std::is_convertible_v<std::decay_t<T>, const char *> ||
+                        std::is_same_v<std::decay_t<T>, std::string_view>,
+                std::string, std::decay_t<T>>;
+
+        /// @brief Format string and captured arguments
+        template <typename... Args> class DeferredFormatImpl : public DeferredFormat {
+        public:
+            template <typename... Ts>
+            DeferredFormatImpl(std::string_view fmt, Ts &&...args)
+                    : m_fmt(fmt), m_args(std::forward<Ts>(args)...) {}
+
+            void render(std::string &out) const override;
+
+        private:
+            std::string_view m_fmt;
+            std::tuple<Args...> m_args;
+        };
+
+        /// @brief Capture a format string and its arguments
+        template <typename... Args>
+        std::unique_ptr<DeferredFormat> makeDeferredFormat(std::string_view fmt, Args &&...args) {
+            return std::make_unique<DeferredFormatImpl<capture_t<Args>...>>(
+                    fmt, std::forward<Args>(args)...);
+        }
+    } // namespace detail
+} // namespace AsyncQueue
+
+#include "AsyncQueue/Format.ixx"
+
+#endif //> !ASYNCQUEUE_FORMAT_HXX
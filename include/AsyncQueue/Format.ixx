@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+
+namespace AsyncQueue {
+    template <typename... Args>
+    template <typename S>
+        requires std::convertible_to<const S &, std::string_view>
+    consteval BasicFormatString<Args...>::BasicFormatString(const S &str) : m_str(str) {
+        // Any throw here makes the constructor call ill-formed, so a bad string fails to compile
+        std::size_t nAutomatic = 0;
+        std::size_t nManual = 0;
+        for (std::size_t pos = 0; pos < m_str.size(); ++pos) {
+            char c = m_str[pos];
+            if (c != '{' && c != '}')
+                continue;
+            if (pos + 1 < m_str.size() && m_str[pos + 1] == c) {
+                ++pos;
+                continue;
+            }
+            if (c == '}')
+                throw std::invalid_argument("Unmatched '}' in format string");
+            std::size_t end = m_str.find('}', pos);
+            if (end == std::string_view::npos)
+                throw std::invalid_argument("Unterminated replacement field in format string");
+            std::string_view id = m_str.substr(pos + 1, end - pos - 1);
+            id = id.substr(0, id.find(':'));
+            if (id.empty())
+                ++nAutomatic;
+            else {
+                std::size_t index = 0;
+                for (char digit : id) {
+                    if (digit < '0' || digit > '9')
+                        throw std::invalid_argument("Invalid argument index in format string");
+                    index = 10 * index + (digit - '0');
+                }
+                nManual = std::max(nManual, index + 1);
+            }
+            pos = end;
+        }
+        if (nAutomatic > 0 && nManual > 0)
+            throw std::invalid_argument("Cannot mix automatic and manual argument indices");
+        if (std::max(nAutomatic, nManual) > sizeof...(Args))
+            throw std::invalid_argument("Format string refers to more arguments than provided");
+    }
+
+    namespace detail {
+        /// @brief Unbuffered stream buffer which appends to a string
+        class StringAppendBuffer : public std::streambuf {
+        public:
+            StringAppendBuffer(std::string &out) : m_out(out) {}
+
+        protected:
+            int_type overflow(int_type ch) override {
+                if (!traits_type::eq_int_type(ch, traits_type::eof()))
+                    m_out.push_back(traits_type::to_char_type(ch));
+                return traits_type::not_eof(ch);
+            }
+            std::streamsize xsputn(const char *s, std::streamsize count) override {
+                m_out.append(s, count);
+                return count;
+            }
+
+        private:
+            std::string &m_out;
+        };
+    } // namespace detail
+
+    template <typename... Args>
+    void formatTo(std::string &out, std::string_view fmt, const Args &...args) {
+#ifdef __cpp_lib_format
+        std::vformat_to(std::back_inserter(out), fmt, std::make_format_args(args...));
+#else
+        detail::StringAppendBuffer buffer(out);
+        std::ostream os(&buffer);
+        std::size_t nextIndex = 0;
+        std::size_t pos = 0;
+        while (pos < fmt.size()) {
+            std::size_t brace = fmt.find_first_of("{}", pos);
+            out.append(fmt.substr(pos, brace - pos));
+            if (brace == std::string_view::npos)
+                break;
+            if (brace + 1 < fmt.size() && fmt[brace + 1] == fmt[brace]) {
+                out.push_back(fmt[brace]);
+                pos = brace + 2;
+                continue;
+            }
+            std::size_t end = fmt.find('}', brace);
+            if (fmt[brace] == '}' || end == std::string_view::npos)
+                throw std::invalid_argument("Unmatched brace in format string");
+            std::string_view id = fmt.substr(brace + 1, end - brace - 1);
+            id = id.substr(0, id.find(':'));
+            std::size_t index = 0;
+            if (id.empty())
+                index = nextIndex++;
+            else
+                for (char digit : id)
+                    index = 10 * index + (digit - '0');
+            if (index >= sizeof...(Args))
+                throw std::out_of_range("Format argument index out of range");
+            std::size_t current = 0;
+            ((current++ == index ? void(os << args) : void()), ...);
+            pos = end + 1;
+        }
+#endif
+    }
+
+    namespace detail {
+        template <typename... Args>
+        void DeferredFormatImpl<Args...>::render(std::string &out) const {
+            std::size_t initialSize = out.size();
+            try {
+                std::apply([&](const Args &...args) { formatTo(out, m_fmt, args...); }, m_args);
+            } catch (const std::exception &e) {
+                // This runs on the consumer thread so report the problem in the message instead
+                out.resize(initialSize);
+                out.append("[format error: ").append(e.what()).append("] ").append(m_fmt);
+            }
+        }
+    } // namespace detail
+} // namespace AsyncQueue
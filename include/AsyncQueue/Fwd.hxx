@@ -5,11 +5,16 @@
 #define ASYNCQUEUE_FWD_HXX
 
 namespace AsyncQueue {
+    enum class MessageLevel;
     class Message;
     template <typename T> class AsyncQueue;
     using MessageQueue = AsyncQueue<Message>;
     template <typename T> class IConsumer;
+    template <typename T> class IBatchConsumer;
     using IMessageWriter = IConsumer<Message>;
+#ifdef AsyncQueue_MULTITHREAD
+    class Executor;
+#endif
 } // namespace AsyncQueue
 
 #endif //> !ASYNCQUEUE_FWD_HXX
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef ASYNCQUEUE_IBATCHCONSUMER_HXX
+#define ASYNCQUEUE_IBATCHCONSUMER_HXX
+
+#include "AsyncQueue/Batch.hxx"
+#include "AsyncQueue/Fwd.hxx"
+#include "AsyncQueue/IConsumer.hxx"
+#include "AsyncQueue/TaskStatus.hxx"
+
+#include <span>
+
+/**
+ * @file IBatchConsumer.hxx
+ *
+ * Templated base class for objects which consume several queue elements at once
+ */
+
+namespace AsyncQueue {
+    /**
+     * @brief Base class for objects which consume elements from a queue in batches
+     * @tparam T The type of element being consumed
+     *
+     * ManagedQueue and TeeConsumer detect consumers of this type and pass them whole batches of
+     * elements, drained from the queue under a single lock. Single elements are forwarded as a
+     * batch of one.
+     */
+    template <typename T> class IBatchConsumer : public IConsumer<T> {
+    public:
+        /// @brief Create the consumer
+        /// @param options How elements should be grouped before being passed to this
+        IBatchConsumer(const BatchOptions &options = {}) : m_batchOptions(options) {}
+
+        using IConsumer<T>::operator();
+        /// @brief Consume several elements
+        /// @param elements The queue elements to be consumed, in queue order
+        /// @return Code indicating the status of the consumer
+        TaskStatus operator()(std::span<const T> elements) { return consume(elements); }
+
+        /**
+         * @brief Consume several elements of the queue
+         * @param elements The elements being consumed, in queue order
+         * @return Code indicating the status of the consumer
+         */
+        virtual TaskStatus consume(std::span<const T> elements) = 0;
+
+        /// @brief Consume a single element of the queue
+        TaskStatus consume(const T &element) override {
+            return consume(std::span<const T>(&element, 1));
+        }
+
+        /// @brief How elements should be grouped before being passed to this
+        const BatchOptions &batchOptions() const { return m_batchOptions; }
+
+        /// @brief Set how elements should be grouped before being passed to this
+        ///
+        /// This is read by a ManagedQueue when its consumer thread starts so it should be set
+        /// before the consumer is handed to the queue.
+        void setBatchOptions(const BatchOptions &options) { m_batchOptions = options; }
+
+    private:
+        BatchOptions m_batchOptions;
+    };
+} // namespace AsyncQueue
+
+#endif //> !ASYNCQUEUE_IBATCHCONSUMER_HXX
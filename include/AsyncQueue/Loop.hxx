@@ -2,13 +2,17 @@
 #ifndef ASYNCQUEUE_LOOP_HXX
 #define ASYNCQUEUE_LOOP_HXX
 
+#include "AsyncQueue/Executor.hxx"
 #include "AsyncQueue/TaskStatus.hxx"
 #include "AsyncQueue/concepts.hxx"
 
 #include <concepts>
 #include <functional>
 #include <future>
+#include <memory>
+#include <optional>
 #include <stop_token>
+#include <tuple>
 
 namespace AsyncQueue {
 
@@ -118,6 +122,74 @@ namespace AsyncQueue {
     /// @return A future containing whether the timeout was responsible for stopping the source
     template <concepts::TimePoint T>
     std::future<bool> setTimeout(std::stop_source ss, const T &timepoint);
+
+    /// @name Executor overloads
+    /// These behave in the same way as the overloads above, but rather than starting a thread of
+    /// their own each iteration runs as a separate task on the provided executor. Periodic tasks
+    /// wait for their next iteration in the executor's timer wheel, so they occupy neither a
+    /// thread nor a pool thread between iterations. Arguments are decayed and stored in the same
+    /// way as for std::async.
+    ///
+    /// The executor must outlive the task. Unlike the futures returned by std::async, destroying
+    /// the returned future does not wait for the task to finish.
+    /// @{
+    template <concepts::Duration D, typename F, typename... Args>
+        requires LoopingTask<F, Args...>
+    std::future<TaskStatus> loop(
+            Executor &executor, std::stop_source ss, const D &period, F &&f, Args &&...args);
+
+    template <typename F, typename... Args>
+        requires LoopingTask<F, Args...>
+    std::future<TaskStatus> loop(Executor &executor, std::stop_source ss, F &&f, Args &&...args);
+
+    template <concepts::Duration D, typename F, typename... Args>
+        requires std::invocable<F, Args...> && (!LoopingTask<F, Args...>)
+    std::future<void> loop(
+            Executor &executor, std::stop_source ss, const D &period, F &&f, Args &&...args);
+
+    template <typename F, typename... Args>
+        requires std::invocable<F, Args...> && (!LoopingTask<F, Args...>)
+    std::future<void> loop(Executor &executor, std::stop_source ss, F &&f, Args &&...args);
+
+    /// @brief Stop the source after the specified period using the executor's timer
+    template <concepts::Duration D>
+    std::future<bool> setTimeout(Executor &executor, std::stop_source ss, const D &duration);
+
+    /// @brief Stop the source at the specified time using the executor's timer
+    template <concepts::TimePoint T>
+    std::future<bool> setTimeout(Executor &executor, std::stop_source ss, const T &timepoint);
+    /// @}
+
+    namespace detail {
+        /**
+         * @brief State of a looping task running on an executor
+         * @tparam R The result type of the loop, either TaskStatus or void
+         *
+         * Each iteration is a separate task which resubmits (or, for periodic tasks, reschedules)
+         * itself until the loop ends.
+         */
+        template <typename R, typename F, typename... Args>
+        class ExecutorLoop : public std::enable_shared_from_this<ExecutorLoop<R, F, Args...>> {
+        public:
+            template <typename G, typename... Ts>
+            ExecutorLoop(
+                    Executor &executor, std::stop_source ss,
+                    std::optional<Executor::clock_t::duration> period, G &&f, Ts &&...args);
+
+            /// @brief Submit the first iteration and return the future for the final result
+            std::future<R> start();
+
+        private:
+            void run();
+
+            Executor &m_executor;
+            std::stop_source m_ss;
+            std::optional<Executor::clock_t::duration> m_period;
+            F m_f;
+            std::tuple<Args...> m_args;
+            std::promise<R> m_promise;
+        };
+    } // namespace detail
 } // namespace AsyncQueue
 
 #include "AsyncQueue/Loop.ixx"
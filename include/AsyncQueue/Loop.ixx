@@ -121,4 +121,142 @@ namespace AsyncQueue {
                 },
                 ss, timepoint);
     }
-} // namespace AsyncQueue
\ No newline at end of file
+
+    namespace detail {
+        template <typename R, typename F, typename... Args>
+        template <typename G, typename... Ts>
+        ExecutorLoop<R, F, Args...>::ExecutorLoop(
+                Executor &executor, std::stop_source ss,
+                std::optional<Executor::clock_t::duration> period, G &&f, Ts &&...args)
+                : m_executor(executor), m_ss(ss), m_period(period), m_f(std::forward<G>(f)),
+                  m_args(std::forward<Ts>(args)...) {}
+
+        template <typename R, typename F, typename... Args>
+        std::future<R> ExecutorLoop<R, F, Args...>::start() {
+            auto future = m_promise.get_future();
+            m_executor.submit([self = this->shared_from_this()]() { self->run(); });
+            return future;
+        }
+
+        template <typename R, typename F, typename... Args>
+        void ExecutorLoop<R, F, Args...>::run() {
+            if (m_ss.stop_requested()) {
+                if constexpr (std::is_void_v<R>)
+                    m_promise.set_value();
+                else
+                    m_promise.set_value(TaskStatus::CONTINUE);
+                return;
+            }
+            auto next = Executor::clock_t::now() + m_period.value_or(Executor::clock_t::duration{});
+            TaskStatus status{TaskStatus::CONTINUE};
+            try {
+                if constexpr (std::is_void_v<R>)
+                    std::apply(m_f, m_args);
+                else
+                    status = std::apply(m_f, m_args);
+            } catch (...) {
+                m_ss.request_stop();
+                m_promise.set_exception(std::current_exception());
+                return;
+            }
+
+            switch (status) {
+            case TaskStatus::CONTINUE:
+                if (m_period)
+                    m_executor.schedule(next, [self = this->shared_from_this()]() { self->run(); });
+                else
+                    m_executor.submit([self = this->shared_from_this()]() { self->run(); });
+                return;
+            case TaskStatus::HALT:
+                if constexpr (!std::is_void_v<R>)
+                    m_promise.set_value(TaskStatus::HALT);
+                return;
+            case TaskStatus::ABORT:
+                m_ss.request_stop();
+                if constexpr (!std::is_void_v<R>)
+                    m_promise.set_value(TaskStatus::ABORT);
+                return;
+            }
+        }
+
+        /// @brief Convert a time point on any clock to the executor's clock
+        template <concepts::TimePoint T> Executor::clock_t::time_point toExecutorTime(const T &tp) {
+            if constexpr (std::is_same_v<typename T::clock, Executor::clock_t>)
+                return std::chrono::time_point_cast<Executor::clock_t::duration>(tp);
+            else
+                return Executor::clock_t::now() +
+                       std::chrono::duration_cast<Executor::clock_t::duration>(
+                               tp - T::clock::now());
+        }
+    } // namespace detail
+
+    template <concepts::Duration D, typename F, typename... Args>
+        requires LoopingTask<F, Args...>
+    std::future<TaskStatus> loop(
+            Executor &executor, std::stop_source ss, const D &period, F &&f, Args &&...args) {
+        return std::make_shared<
+                       detail::ExecutorLoop<TaskStatus, std::decay_t<F>, std::decay_t<Args>...>>(
+                       executor, ss,
+                       std::chrono::duration_cast<Executor::clock_t::duration>(period),
+                       std::forward<F>(f), std::forward<Args>(args)...)
+                ->start();
+    }
+
+    template <typename F, typename... Args>
+        requires LoopingTask<F, Args...>
+    std::future<TaskStatus> loop(Executor &executor, std::stop_source ss, F &&f, Args &&...args) {
+        return std::make_shared<
+                       detail::ExecutorLoop<TaskStatus, std::decay_t<F>, std::decay_t<Args>...>>(
+                       executor, ss, std::nullopt, std::forward<F>(f),
+                       std::forward<Args>(args)...)
+                ->start();
+    }
+
+    template <concepts::Duration D, typename F, typename... Args>
+        requires std::invocable<F, Args...> && (!LoopingTask<F, Args...>)
+    std::future<void> loop(
+            Executor &executor, std::stop_source ss, const D &period, F &&f, Args &&...args) {
+        return std::make_shared<detail::ExecutorLoop<void, std::decay_t<F>, std::decay_t<Args>...>>(
+                       executor, ss,
+                       std::chrono::duration_cast<Executor::clock_t::duration>(period),
+                       std::forward<F>(f), std::forward<Args>(args)...)
+                ->start();
+    }
+
+    template <typename F, typename... Args>
+        requires std::invocable<F, Args...> && (!LoopingTask<F, Args...>)
+    std::future<void> loop(Executor &executor, std::stop_source ss, F &&f, Args &&...args) {
+        return std::make_shared<detail::ExecutorLoop<void, std::decay_t<F>, std::decay_t<Args>...>>(
+                       executor, ss, std::nullopt, std::forward<F>(f), std::forward<Args>(args)...)
+                ->start();
+    }
+
+    template <concepts::Duration D>
+    std::future<bool> setTimeout(Executor &executor, std::stop_source ss, const D &duration) {
+        return setTimeout(executor, ss, std::chrono::steady_clock::now() + duration);
+    }
+
+    template <concepts::TimePoint T>
+    std::future<bool> setTimeout(Executor &executor, std::stop_source ss, const T &timepoint) {
+        struct State {
+            std::promise<bool> promise;
+            std::atomic<bool> done{false};
+            std::optional<std::stop_callback<std::function<void()>>> onStop;
+        };
+        auto state = std::make_shared<State>();
+        auto future = state->promise.get_future();
+        // If the source is stopped elsewhere first then the timeout was not responsible
+        state->onStop.emplace(ss.get_token(), [weak = std::weak_ptr<State>(state)]() {
+            if (auto s = weak.lock(); s && !s->done.exchange(true))
+                s->promise.set_value(false);
+        });
+        executor.schedule(detail::toExecutorTime(timepoint), [state, ss]() mutable {
+            if (!state->done.exchange(true)) {
+                ss.request_stop();
+                state->promise.set_value(true);
+            }
+            state->onStop.reset();
+        });
+        return future;
+    }
+} // namespace AsyncQueue
@@ -2,8 +2,19 @@
 #define ASYNCQUEUE_MANAGEDQUEUE_HXX
 
 #include "AsyncQueue/AsyncQueue.hxx"
+#include "AsyncQueue/Batch.hxx"
+#include "AsyncQueue/IBatchConsumer.hxx"
 #include "AsyncQueue/IConsumer.hxx"
+#include "AsyncQueue/Overflow.hxx"
+#include "AsyncQueue/QueueStats.hxx"
+#include <chrono>
+#include <functional>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <vector>
 
 namespace AsyncQueue {
     /// @brief Async queue with its own associated stop source and dedicated consumer
@@ -12,7 +23,22 @@ namespace AsyncQueue {
     /// When the associated stop has been requested any remaining elements of the queue will be
     /// processed by the consumer, but no new elements will be accepted. The consumer pointer can be
     /// owned and managed by the queue, or it can merely hold an observing pointer.
-    template <typename T> class ManagedQueue {
+    ///
+    /// The consumer thread drains the queue in batches. If the consumer is an IBatchConsumer it
+    /// receives each batch in one call (grouped according to its batchOptions), otherwise it is
+    /// passed the elements of the batch one by one. If such a consumer stops part way through a
+    /// batch the elements it did not reach are returned to the front of the queue. Queues which
+    /// cannot take elements back (see concepts::RequeueableQueue) are drained one element at a
+    /// time for these consumers instead.
+    ///
+    /// Once the consumer has finished, either because the stop was requested or because it
+    /// returned HALT or ABORT, the queue is closed: pushes are ignored and producers which block
+    /// on a full bounded queue are released.
+    ///
+    /// @tparam Queue The underlying queue type. This can be any type with the same push, extract,
+    /// size and waitForElement interface as AsyncQueue (e.g. a RingBufferQueue). The lock based
+    /// methods are only available if the queue is itself lock based.
+    template <typename T, typename Queue = AsyncQueue<T>> class ManagedQueue {
     public:
         using lock_t = std::unique_lock<std::mutex>;
 #ifdef AsyncQueue_MULTITHREAD
@@ -22,6 +48,20 @@ namespace AsyncQueue {
         template <std::derived_from<IConsumer<T>> Consumer>
             requires std::move_constructible<Consumer>
         ManagedQueue(std::stop_source ss, Consumer &&consumer);
+
+        /// @name Executor constructors
+        /// Run the consumer as a sequence of tasks on a shared executor rather than on a dedicated
+        /// thread. The destructor still waits for the consumer to drain the queue, so the queue
+        /// should not be destroyed from a task on the same executor unless another thread is free
+        /// to run the consumer.
+        /// @{
+        ManagedQueue(
+                Executor &executor, std::stop_source ss, std::unique_ptr<IConsumer<T>> consumer);
+        ManagedQueue(Executor &executor, std::stop_source ss, IConsumer<T> *consumer);
+        template <std::derived_from<IConsumer<T>> Consumer>
+            requires std::move_constructible<Consumer>
+        ManagedQueue(Executor &executor, std::stop_source ss, Consumer &&consumer);
+        /// @}
 #endif
         ManagedQueue(std::unique_ptr<IConsumer<T>> consumer);
         template <std::derived_from<IConsumer<T>> Consumer>
@@ -31,34 +71,105 @@ namespace AsyncQueue {
         ~ManagedQueue();
 
         /// @brief Get the mutex protecting the queue
-        std::mutex &mutex() const { return m_queue.mutex(); }
+        std::mutex &mutex() const
+            requires concepts::LockableQueue<Queue>
+        {
+            return m_queue.mutex();
+        }
         /// @brief Acquire a lock on the queue
-        lock_t lock() const { return m_queue.lock(); }
+        lock_t lock() const
+            requires concepts::LockableQueue<Queue>
+        {
+            return m_queue.lock();
+        }
         /// @brief Get the condition variable for the queue
-        std::condition_variable_any &cv() { return m_queue.cv(); }
+        std::condition_variable_any &cv()
+            requires concepts::LockableQueue<Queue>
+        {
+            return m_queue.cv();
+        }
 
 #ifdef AsyncQueue_MULTITHREAD
         /// @brief Get the stop source
         std::stop_source stopSource() { return m_ss; }
         /// @brief Get a stop token for the associated source
         std::stop_token stopToken() const { return m_ss.get_token(); }
+        /// @brief Get a stop token which is stopped once the queue no longer accepts elements
+        ///
+        /// This happens when the stop is requested or when the consumer halts or aborts. Code
+        /// which pushes to the underlying queue directly should pass this to its pushes so that
+        /// it never waits for space which the consumer will not make.
+        std::stop_token closedToken() const { return m_closed.get_token(); }
         /// @brief Access the future of the consuming thread
         std::future<TaskStatus> &consumerStatus() { return m_consumerStatus; }
 #endif
         /// @brief Access the async queue
-        AsyncQueue<T> &queue() { return m_queue; }
+        Queue &queue() { return m_queue; }
+
+        /// @name Overflow control
+        /// Bound the size of the underlying queue, see AsyncQueue::setCapacity
+        /// @{
+        void setCapacity(std::size_t capacity, OverflowPolicy policy = OverflowPolicy::Block)
+            requires concepts::BoundedQueue<Queue>
+        {
+            m_queue.setCapacity(capacity, policy);
+        }
+        void setCapacity(std::size_t capacity, MessageLevel dropBelow)
+            requires concepts::BoundedQueue<Queue> && concepts::HasMessageLevel<T>
+        {
+            m_queue.setCapacity(capacity, dropBelow);
+        }
+        /// @brief The number of elements discarded by the overflow policy so far
+        DropCounts dropCounts() const
+            requires concepts::BoundedQueue<Queue>
+        {
+            return m_queue.dropCounts();
+        }
+        /// @}
+
+        /// @brief A snapshot of the queue's statistics, empty unless AsyncQueue_INSTRUMENT is set
+        ///
+        /// The consumer's service time is recorded for any queue type, the other statistics are
+        /// only available if the underlying queue provides them.
+        QueueStats stats() const {
+            QueueStats stats;
+            if constexpr (requires(const Queue &q) {
+                              { q.stats() } -> std::same_as<QueueStats>;
+                          })
+                stats = m_queue.stats();
+#ifdef AsyncQueue_INSTRUMENT
+            std::lock_guard lock(m_statsMutex);
+            stats.serviceTime = m_serviceTime;
+#endif
+            return stats;
+        }
 
         /// @name Push methods
         /// The push methods take a const reference (copy) or an rvalue reference (move) to a value
         /// to add to the queue. For both version a lock can also be provided. In this case it
         /// *must* be the queue's own lock. If a lock isn't provided the @ref lock method will be
         /// used to supply one.
-        /// If the stop has been requested the push will be ignored and false will be returned.
+        /// If the queue has been closed (see closedToken), or the value is rejected by the queue's
+        /// overflow policy, the push will be ignored and false will be returned.
         /// @{
-        bool push(const T &value) { return push(value, lock()); }
-        bool push(const T &value, const lock_t &lock);
-        bool push(T &&value) { return push(std::move(value), lock()); }
-        bool push(T &&value, const lock_t &lock);
+        bool push(const T &value);
+        bool push(const T &value, const lock_t &lock)
+            requires concepts::LockableQueue<Queue>;
+        bool push(T &&value);
+        bool push(T &&value, const lock_t &lock)
+            requires concepts::LockableQueue<Queue>;
+        /// @}
+
+        /// @name Bulk push methods
+        /// Push several values at once, see AsyncQueue::pushRange and AsyncQueue::pushBulk.
+        /// Returns the number of elements accepted, which is 0 if the stop has been requested.
+        /// @{
+        template <std::input_iterator It, std::sentinel_for<It> S>
+        std::size_t pushRange(It first, S last);
+        template <std::ranges::input_range R> std::size_t pushRange(R &&range) {
+            return pushRange(std::ranges::begin(range), std::ranges::end(range));
+        }
+        std::size_t pushBulk(std::vector<T> &&values);
         /// @}
 
         /**
@@ -77,42 +188,99 @@ namespace AsyncQueue {
          *
          * @param lock Should be an already acquired lock to the correct mutex
          */
-        std::optional<T> extract(const lock_t &lock) { return m_queue.extract(lock); }
+        std::optional<T> extract(const lock_t &lock)
+            requires concepts::LockableQueue<Queue>
+        {
+            return m_queue.extract(lock);
+        }
 
         /// @brief Get the number of elements in the queue
         std::size_t size() const { return m_queue.size(); }
 
         /// @brief Get the number of elements in the queue
-        std::size_t size(const lock_t &lock) const { return m_queue.size(lock); }
+        std::size_t size(const lock_t &lock) const
+            requires concepts::LockableQueue<Queue>
+        {
+            return m_queue.size(lock);
+        }
 
         /// @brief Is the queue empty?
         bool empty() const { return m_queue.empty(); }
 
         /// @brief Is the queue empty?
-        bool empty(const lock_t &lock) const { return m_queue.empty(lock); }
+        bool empty(const lock_t &lock) const
+            requires concepts::LockableQueue<Queue>
+        {
+            return m_queue.empty(lock);
+        }
 
 #ifdef AsyncQueue_MULTITHREAD
         template <typename F, typename... Args>
-            requires Producer<F, T, Args...>
+            requires QueueProducer<F, Queue, Args...>
+        std::future<TaskStatus> loopProducer(Executor &executor, F &&f, Args &&...args) {
+            return m_queue.loopProducer(
+                    executor, m_ss, std::forward<F>(f), std::forward<Args>(args)...);
+        }
+
+        template <concepts::Duration D, typename F, typename... Args>
+            requires QueueProducer<F, Queue, Args...>
+        std::future<TaskStatus> loopProducer(
+                Executor &executor, const D &d, F &&f, Args &&...args) {
+            return m_queue.loopProducer(
+                    executor, m_ss, d, std::forward<F>(f), std::forward<Args>(args)...);
+        }
+
+        template <typename F, typename... Args>
+            requires QueueProducer<F, Queue, Args...>
         std::future<TaskStatus> loopProducer(F &&f, Args &&...args) {
             return m_queue.loopProducer(m_ss, std::forward<F>(f), std::forward<Args>(args)...);
         }
 
         template <concepts::Duration D, typename F, typename... Args>
-            requires Producer<F, T, Args...>
+            requires QueueProducer<F, Queue, Args...>
         std::future<TaskStatus> loopProducer(const D &d, F &&f, Args &&...args) {
             return m_queue.loopProducer(m_ss, d, std::forward<F>(f), std::forward<Args>(args)...);
         }
 #endif
 
     private:
+        /// @brief Make a call to the consumer, recording its service time
+        template <typename F> TaskStatus serviced(F &&callConsumer) {
+#ifdef AsyncQueue_INSTRUMENT
+            auto start = std::chrono::steady_clock::now();
+            TaskStatus status = callConsumer();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            std::lock_guard lock(m_statsMutex);
+            m_serviceTime.record(elapsed);
+            return status;
+#else
+            return callConsumer();
+#endif
+        }
 #ifdef AsyncQueue_MULTITHREAD
         TaskStatus consumerThread();
+        std::future<TaskStatus> startConsumer(Executor &executor);
+        /// @brief The batch options to use for the consumer
+        BatchOptions consumerOptions() const;
+        /// @brief Pass a batch to the consumer, or each element if it doesn't accept batches
+        TaskStatus consumeBatch(std::span<T> batch);
         std::stop_source m_ss;
+        /// @brief Stopped once the queue no longer accepts elements, see closedToken
+        std::stop_source m_closed;
+        std::stop_callback<std::function<void()>> m_closeOnStop{
+                m_ss.get_token(), [this]() { m_closed.request_stop(); }};
 #endif
-        AsyncQueue<T> m_queue;
+        Queue m_queue;
         IConsumer<T> *m_consumer;
+#ifdef AsyncQueue_MULTITHREAD
+        /// @brief The consumer if it accepts batches, resolved once on construction
+        IBatchConsumer<T> *m_batchConsumer;
+#endif
         std::unique_ptr<IConsumer<T>> m_consumerOwning;
+#ifdef AsyncQueue_INSTRUMENT
+        mutable std::mutex m_statsMutex;
+        LatencyHistogram m_serviceTime;
+#endif
 #ifdef AsyncQueue_MULTITHREAD
         std::future<TaskStatus> m_consumerStatus;
 #endif
@@ -1,41 +1,24 @@
-namespace AsyncQueue {
+#include <algorithm>
+#include <span>
 
-    template <typename T> TaskStatus ManagedQueue<T>::consumerThread() {
-        auto st = m_ss.get_token();
-        while (!st.stop_requested()) {
-            auto lock_ = this->lock();
-            while (auto next = this->extract(lock_)) {
-                // Unlock while the consumer consumes the value. It's also important to
-                // ensure that the queue is not locked if request_stop is called as any
-                // callbacks that need to access the queue will be unable to acquire the
-                // lock.
-                lock_.unlock();
-                TaskStatus status{TaskStatus::CONTINUE};
-                try {
-                    status = (*m_consumer)(*next);
-                } catch (...) {
-                    this->m_ss.request_stop();
-                    throw;
-                }
+namespace AsyncQueue {
 
-                switch (status) {
-                case TaskStatus::CONTINUE:
-                    break;
-                case TaskStatus::HALT:
-                    return TaskStatus::HALT;
-                case TaskStatus::ABORT:
-                    this->m_ss.request_stop();
-                    return TaskStatus::ABORT;
-                }
-                lock_.lock();
-            }
-            this->cv().wait(lock_, st, [this]() { return true; });
-        }
+    template <typename T, typename Queue> TaskStatus ManagedQueue<T, Queue>::consumerThread() {
+        // The queue is only accessed once per batch and is not locked while the consumer consumes
+        // the values. It's also important to ensure that the queue is not locked if request_stop
+        // is called as any callbacks that need to access the queue will be unable to acquire the
+        // lock.
+        BatchOptions options = consumerOptions();
+        auto consumeBatch = [this](std::span<T> batch) { return this->consumeBatch(batch); };
+        if (TaskStatus status = detail::consumeBatches(m_queue, m_ss, options, consumeBatch);
+            status != TaskStatus::CONTINUE)
+            return status;
         // Now go through all remaining queue elements
-        auto lock_ = this->lock();
-        while (auto next = this->extract(lock_)) {
-            switch (TaskStatus status = (*m_consumer)(*next)) {
+        std::vector<T> batch;
+        while (m_queue.extractBatch(batch, options.maxSize) > 0) {
+            switch (TaskStatus status = consumeBatch(batch)) {
             case TaskStatus::CONTINUE:
+                batch.clear();
                 continue;
             default:
                 return status;
@@ -44,50 +27,151 @@ namespace AsyncQueue {
         return TaskStatus::CONTINUE;
     }
 
-    template <typename T>
-    ManagedQueue<T>::ManagedQueue(std::stop_source ss, IConsumer<T> *consumer)
+    template <typename T, typename Queue>
+    std::future<TaskStatus> ManagedQueue<T, Queue>::startConsumer(Executor &executor) {
+        auto consumeBatch = [this](std::span<T> batch) { return this->consumeBatch(batch); };
+        // Remaining elements are drained after the stop, as for the consumer thread
+        return detail::ExecutorConsumer<Queue, decltype(consumeBatch)>::start(
+                executor, m_queue, m_ss, consumerOptions(), consumeBatch, true);
+    }
+
+    template <typename T, typename Queue>
+    BatchOptions ManagedQueue<T, Queue>::consumerOptions() const {
+        BatchOptions options = m_batchConsumer ? m_batchConsumer->batchOptions() : BatchOptions{};
+        // Elements left over when a consumer halts mid-batch must go back into the queue
+        if (!m_batchConsumer && !concepts::RequeueableQueue<Queue>)
+            options.maxSize = 1;
+        options.maxSize = std::max<std::size_t>(options.maxSize, 1);
+        return options;
+    }
+
+    template <typename T, typename Queue>
+    TaskStatus ManagedQueue<T, Queue>::consumeBatch(std::span<T> batch) {
+        TaskStatus status{TaskStatus::CONTINUE};
+        if (m_batchConsumer)
+            status = serviced([&]() { return m_batchConsumer->consume(batch); });
+        else
+            for (std::size_t idx = 0; idx < batch.size(); ++idx)
+                if ((status = serviced([&]() { return (*m_consumer)(batch[idx]); })) !=
+                    TaskStatus::CONTINUE) {
+                    // Leave the elements the consumer didn't reach in the queue
+                    if constexpr (concepts::RequeueableQueue<Queue>)
+                        m_queue.requeue(batch.subspan(idx + 1));
+                    break;
+                }
+        // Nothing will consume any more elements so stop accepting them and release any blocked
+        // producers
+        if (status != TaskStatus::CONTINUE)
+            m_closed.request_stop();
+        return status;
+    }
+
+    template <typename T, typename Queue>
+    ManagedQueue<T, Queue>::ManagedQueue(std::stop_source ss, IConsumer<T> *consumer)
             : m_ss(ss), m_consumer(consumer),
+              m_batchConsumer(dynamic_cast<IBatchConsumer<T> *>(consumer)),
               m_consumerStatus(
                       std::async(std::launch::async, &ManagedQueue::consumerThread, this)) {}
 
-    template <typename T>
-    ManagedQueue<T>::ManagedQueue(std::stop_source ss, std::unique_ptr<IConsumer<T>> consumer)
-            : m_ss(ss), m_consumer(consumer.get()), m_consumerOwning(std::move(consumer)),
+    template <typename T, typename Queue>
+    ManagedQueue<T, Queue>::ManagedQueue(
+            std::stop_source ss, std::unique_ptr<IConsumer<T>> consumer)
+            : m_ss(ss), m_consumer(consumer.get()),
+              m_batchConsumer(dynamic_cast<IBatchConsumer<T> *>(consumer.get())),
+              m_consumerOwning(std::move(consumer)),
               m_consumerStatus(
                       std::async(std::launch::async, &ManagedQueue::consumerThread, this)) {}
 
-    template <typename T>
-    ManagedQueue<T>::ManagedQueue(IConsumer<T> *consumer)
+    template <typename T, typename Queue>
+    ManagedQueue<T, Queue>::ManagedQueue(IConsumer<T> *consumer)
             : ManagedQueue(std::stop_source(), consumer) {}
 
-    template <typename T>
-    ManagedQueue<T>::ManagedQueue(std::unique_ptr<IConsumer<T>> consumer)
+    template <typename T, typename Queue>
+    ManagedQueue<T, Queue>::ManagedQueue(std::unique_ptr<IConsumer<T>> consumer)
             : ManagedQueue(std::stop_source(), std::move(consumer)) {}
-    template <typename T>
+    template <typename T, typename Queue>
     template <std::derived_from<IConsumer<T>> Consumer>
         requires std::move_constructible<Consumer>
-    ManagedQueue<T>::ManagedQueue(std::stop_source ss, Consumer &&consumer)
+    ManagedQueue<T, Queue>::ManagedQueue(std::stop_source ss, Consumer &&consumer)
             : ManagedQueue(ss, std::make_unique<Consumer>(std::move(consumer))) {}
 
-    template <typename T>
+    template <typename T, typename Queue>
     template <std::derived_from<IConsumer<T>> Consumer>
         requires std::move_constructible<Consumer>
-    ManagedQueue<T>::ManagedQueue(Consumer &&consumer)
+    ManagedQueue<T, Queue>::ManagedQueue(Consumer &&consumer)
             : ManagedQueue(std::stop_source(), std::make_unique<Consumer>(std::move(consumer))) {}
 
-    template <typename T> ManagedQueue<T>::~ManagedQueue() { m_ss.request_stop(); }
+    template <typename T, typename Queue>
+    ManagedQueue<T, Queue>::ManagedQueue(
+            Executor &executor, std::stop_source ss, IConsumer<T> *consumer)
+            : m_ss(ss), m_consumer(consumer),
+              m_batchConsumer(dynamic_cast<IBatchConsumer<T> *>(consumer)),
+              m_consumerStatus(startConsumer(executor)) {}
+
+    template <typename T, typename Queue>
+    ManagedQueue<T, Queue>::ManagedQueue(
+            Executor &executor, std::stop_source ss, std::unique_ptr<IConsumer<T>> consumer)
+            : m_ss(ss), m_consumer(consumer.get()),
+              m_batchConsumer(dynamic_cast<IBatchConsumer<T> *>(consumer.get())),
+              m_consumerOwning(std::move(consumer)), m_consumerStatus(startConsumer(executor)) {}
+
+    template <typename T, typename Queue>
+    template <std::derived_from<IConsumer<T>> Consumer>
+        requires std::move_constructible<Consumer>
+    ManagedQueue<T, Queue>::ManagedQueue(
+            Executor &executor, std::stop_source ss, Consumer &&consumer)
+            : ManagedQueue(executor, ss, std::make_unique<Consumer>(std::move(consumer))) {}
+
+    template <typename T, typename Queue> ManagedQueue<T, Queue>::~ManagedQueue() {
+        m_ss.request_stop();
+        // A future from std::async would wait on destruction anyway, but one from an executor
+        // would not and the consumer must not outlive the queue
+        if (m_consumerStatus.valid())
+            m_consumerStatus.wait();
+    }
+
+    template <typename T, typename Queue> bool ManagedQueue<T, Queue>::push(const T &value) {
+        if (m_closed.stop_requested())
+            return false;
+        return m_queue.push(value, m_closed.get_token());
+    }
+
+    template <typename T, typename Queue>
+    bool ManagedQueue<T, Queue>::push(const T &value, const lock_t &lock)
+        requires concepts::LockableQueue<Queue>
+    {
+        if (m_closed.stop_requested())
+            return false;
+        return m_queue.push(value, lock, m_closed.get_token());
+    }
 
-    template <typename T> bool ManagedQueue<T>::push(const T &value, const lock_t &lock) {
-        if (m_ss.stop_requested())
+    template <typename T, typename Queue> bool ManagedQueue<T, Queue>::push(T &&value) {
+        if (m_closed.stop_requested())
             return false;
-        m_queue.push(value, lock);
-        return true;
+        return m_queue.push(std::move(value), m_closed.get_token());
     }
 
-    template <typename T> bool ManagedQueue<T>::push(T &&value, const lock_t &lock) {
-        if (m_ss.stop_requested())
+    template <typename T, typename Queue>
+    bool ManagedQueue<T, Queue>::push(T &&value, const lock_t &lock)
+        requires concepts::LockableQueue<Queue>
+    {
+        if (m_closed.stop_requested())
             return false;
-        m_queue.push(std::move(value), lock);
-        return true;
+        return m_queue.push(std::move(value), lock, m_closed.get_token());
+    }
+
+    template <typename T, typename Queue>
+    template <std::input_iterator It, std::sentinel_for<It> S>
+    std::size_t ManagedQueue<T, Queue>::pushRange(It first, S last) {
+        if (m_closed.stop_requested())
+            return 0;
+        return m_queue.pushRange(std::move(first), std::move(last), m_closed.get_token());
+    }
+
+    template <typename T, typename Queue>
+    std::size_t ManagedQueue<T, Queue>::pushBulk(std::vector<T> &&values) {
+        if (m_closed.stop_requested())
+            return 0;
+        return m_queue.pushBulk(std::move(values), m_closed.get_token());
     }
-} // namespace AsyncQueue
\ No newline at end of file
+} // namespace AsyncQueue
@@ -1,26 +1,70 @@
 namespace AsyncQueue {
 
-    template <typename T>
-    ManagedQueue<T>::ManagedQueue(std::unique_ptr<IConsumer<T>> consumer)
+    template <typename T, typename Queue>
+    ManagedQueue<T, Queue>::ManagedQueue(std::unique_ptr<IConsumer<T>> consumer)
             : m_consumer(consumer.get()), m_consumerOwning(std::move(consumer)) {}
-    template <typename T>
-    ManagedQueue<T>::ManagedQueue(IConsumer<T> *consumer) : m_consumer(consumer) {}
-    template <typename T>
+    template <typename T, typename Queue>
+    ManagedQueue<T, Queue>::ManagedQueue(IConsumer<T> *consumer) : m_consumer(consumer) {}
+    template <typename T, typename Queue>
     template <std::derived_from<IConsumer<T>> Consumer>
         requires std::move_constructible<Consumer>
-    ManagedQueue<T>::ManagedQueue(Consumer &&consumer)
+    ManagedQueue<T, Queue>::ManagedQueue(Consumer &&consumer)
             : ManagedQueue(std::make_unique<Consumer>(std::move(consumer))) {}
-    template <typename T> ManagedQueue<T>::~ManagedQueue() {}
+    template <typename T, typename Queue> ManagedQueue<T, Queue>::~ManagedQueue() {}
 
-    template <typename T> bool ManagedQueue<T>::push(const T &value, const lock_t &lock) {
-        m_queue.push(value, lock);
-        m_consumer->consume(*m_queue.extract());
+    template <typename T, typename Queue> bool ManagedQueue<T, Queue>::push(const T &value) {
+        if (!m_queue.push(value))
+            return false;
+        std::optional<T> next = m_queue.extract();
+        serviced([&]() { return m_consumer->consume(*next); });
         return true;
     }
 
-    template <typename T> bool ManagedQueue<T>::push(T &&value, const lock_t &lock) {
-        m_queue.push(std::move(value), lock);
-        m_consumer->consume(*m_queue.extract());
+    template <typename T, typename Queue>
+    bool ManagedQueue<T, Queue>::push(const T &value, const lock_t &lock)
+        requires concepts::LockableQueue<Queue>
+    {
+        if (!m_queue.push(value, lock))
+            return false;
+        std::optional<T> next = m_queue.extract(lock);
+        serviced([&]() { return m_consumer->consume(*next); });
         return true;
     }
-} // namespace AsyncQueue
\ No newline at end of file
+
+    template <typename T, typename Queue> bool ManagedQueue<T, Queue>::push(T &&value) {
+        if (!m_queue.push(std::move(value)))
+            return false;
+        std::optional<T> next = m_queue.extract();
+        serviced([&]() { return m_consumer->consume(*next); });
+        return true;
+    }
+
+    template <typename T, typename Queue>
+    bool ManagedQueue<T, Queue>::push(T &&value, const lock_t &lock)
+        requires concepts::LockableQueue<Queue>
+    {
+        if (!m_queue.push(std::move(value), lock))
+            return false;
+        std::optional<T> next = m_queue.extract(lock);
+        serviced([&]() { return m_consumer->consume(*next); });
+        return true;
+    }
+
+    template <typename T, typename Queue>
+    template <std::input_iterator It, std::sentinel_for<It> S>
+    std::size_t ManagedQueue<T, Queue>::pushRange(It first, S last) {
+        std::size_t count = 0;
+        for (; first != last; ++first)
+            count += push(*first);
+        return count;
+    }
+
+    template <typename T, typename Queue>
+    std::size_t ManagedQueue<T, Queue>::pushBulk(std::vector<T> &&values) {
+        std::size_t count = 0;
+        for (T &value : values)
+            count += push(std::move(value));
+        values.clear();
+        return count;
+    }
+} // namespace AsyncQueue
@@ -2,11 +2,29 @@
 #define ASYNCQUEUE_MESSAGE_HXX
 
 #include "Fwd.hxx"
+#include "SourceRegistry.hxx"
 
+#include <atomic>
 #include <chrono>
 #include <istream>
+#include <memory>
 #include <ostream>
 #include <string>
+#include <string_view>
+
+/// @brief Messages below this level are removed at compile time
+///
+/// The numeric value of a MessageLevel. CMake defines it for the library and everything linked to
+/// it, from the cache variable of the same name or, if that is empty, the build type, so that all
+/// translation units agree. Without CMake VERBOSE and DEBUG messages are removed from NDEBUG
+/// builds and nothing is removed otherwise.
+#ifndef AsyncQueue_MIN_LEVEL
+#ifdef NDEBUG
+#define AsyncQueue_MIN_LEVEL 2
+#else
+#define AsyncQueue_MIN_LEVEL 0
+#endif
+#endif
 
 namespace AsyncQueue {
     /// @brief Enum to indicate the severity of a message
@@ -20,16 +38,91 @@ namespace AsyncQueue {
     /// @param lvl The string form of a message level, case insensitive
     MessageLevel levelFromString(std::string lvl);
 
+    namespace detail {
+        /// @brief Type-erased format string and arguments, see Format.hxx
+        class DeferredFormat {
+        public:
+            virtual ~DeferredFormat() = default;
+            /// @brief Append the formatted text to out
+            virtual void render(std::string &out) const = 0;
+        };
+    } // namespace detail
+
+    /**
+     * @brief Owning buffer for the text of a message
+     *
+     * Wraps a std::string whose storage is returned to a shared pool when the text is destroyed,
+     * and reused by @ref acquire. Message sources take their buffers from the pool so once it has
+     * warmed up creating and consuming a message does not allocate.
+     *
+     * The text can also be created from an unformatted format string and arguments, in which case
+     * it is only formatted the first time it is accessed, normally on the consumer thread. The
+     * formatting is synchronised, so a message shared between consumers (e.g. by a TeeConsumer)
+     * may be read from several threads at once.
+     */
+    class MessageText {
+    public:
+        MessageText() = default;
+        MessageText(std::string text) : m_text(std::move(text)) {}
+        MessageText(std::string_view text);
+        MessageText(const char *text) : MessageText(std::string_view(text)) {}
+        /// @brief Create text which is formatted when it is first accessed
+        explicit MessageText(std::unique_ptr<detail::DeferredFormat> deferred)
+                : m_deferred(std::move(deferred)), m_pending(m_deferred != nullptr) {}
+        MessageText(const MessageText &other) : MessageText(other.view()) {}
+        MessageText(MessageText &&other) noexcept;
+        MessageText &operator=(const MessageText &other);
+        MessageText &operator=(MessageText &&other) noexcept;
+        ~MessageText();
+
+        /// @brief Access the text
+        const std::string &str() const {
+            if (m_pending.load(std::memory_order_acquire))
+                render();
+            return m_text;
+        }
+        /// @brief Access the text
+        operator const std::string &() const { return str(); }
+        /// @brief View the text
+        std::string_view view() const { return str(); }
+        std::size_t size() const { return str().size(); }
+        bool empty() const { return str().empty(); }
+        /// @brief Is the text still waiting to be formatted?
+        bool deferred() const { return m_pending.load(std::memory_order_acquire); }
+
+        /// @brief Take an empty string from the pool, or a new one if the pool is empty
+        static std::string acquire();
+        /// @brief Return a string's storage to the pool
+        static void recycle(std::string &&text);
+
+    private:
+        /// @brief Format deferred text into m_text, unless another thread has already done so
+        void render() const;
+
+        mutable std::string m_text;
+        mutable std::unique_ptr<detail::DeferredFormat> m_deferred;
+        /// @brief Set while m_deferred is waiting to be rendered
+        mutable std::atomic<bool> m_pending{false};
+    };
+
+    inline bool operator==(const MessageText &lhs, std::string_view rhs) {
+        return lhs.view() == rhs;
+    }
+    std::ostream &operator<<(std::ostream &os, const MessageText &text);
+
     /// @brief Struct containing a message with its context
+    ///
+    /// Messages are cheap to move. The source name is interned in the SourceRegistry rather than
+    /// copied into each message, see SourceName.
     struct Message {
         /// @brief The name of the source which generated the message
-        const std::string source;
+        SourceName source;
         /// @brief The time at which it was generated
-        const std::chrono::time_point<std::chrono::system_clock> time;
+        std::chrono::time_point<std::chrono::system_clock> time;
         /// @brief The level (verbosity) of the message
-        const MessageLevel level;
+        MessageLevel level;
         /// @brief The message
-        const std::string message;
+        MessageText message;
     };
 
     /// @brief Three-way comparison operator for the MessageLevel enum
@@ -38,6 +131,13 @@ namespace AsyncQueue {
     }
 
 
+    /// @brief The lowest level which is compiled in, see AsyncQueue_MIN_LEVEL
+    static constexpr inline MessageLevel compiledMinLevel =
+            static_cast<MessageLevel>(AsyncQueue_MIN_LEVEL);
+
+    /// @brief Are messages of this level compiled in?
+    inline constexpr bool isCompiledIn(MessageLevel lvl) { return lvl >= compiledMinLevel; }
+
     std::istream &operator>>(std::istream &is, MessageLevel &lvl);
     std::ostream &operator<<(std::ostream &os, MessageLevel lvl);
 
@@ -20,31 +20,60 @@ namespace AsyncQueue {
         virtual const MessageSource &msgSource() const = 0;
         /// @brief Get a builder for the specified level
         virtual MessageQueueStream msg(MessageLevel lvl) const { return msgSource().msg(lvl); }
+        /// @brief Create a message from a format string and arguments
+        template <typename... Args>
+        void fmtMsg(MessageLevel lvl, FormatString<Args...> fmt, Args &&...args) const {
+            msgSource().fmtMsg(lvl, fmt, std::forward<Args>(args)...);
+        }
 
         MessageQueueStream verboseMsg() const { return msgSource().verboseMsg(); }
         template <typename... Args> void verboseMsg(Args &&...args) const {
             msgSource().verboseMsg(std::forward<Args>(args)...);
         }
+        template <typename... Args>
+        void verboseFmt(FormatString<Args...> fmt, Args &&...args) const {
+            msgSource().verboseFmt(fmt, std::forward<Args>(args)...);
+        }
         MessageQueueStream debugMsg() const { return msgSource().debugMsg(); }
         template <typename... Args> void debugMsg(Args &&...args) const {
             msgSource().debugMsg(std::forward<Args>(args)...);
         }
+        template <typename... Args>
+        void debugFmt(FormatString<Args...> fmt, Args &&...args) const {
+            msgSource().debugFmt(fmt, std::forward<Args>(args)...);
+        }
         MessageQueueStream infoMsg() const { return msgSource().infoMsg(); }
         template <typename... Args> void infoMsg(Args &&...args) const {
             msgSource().infoMsg(std::forward<Args>(args)...);
         }
+        template <typename... Args>
+        void infoFmt(FormatString<Args...> fmt, Args &&...args) const {
+            msgSource().infoFmt(fmt, std::forward<Args>(args)...);
+        }
         MessageQueueStream warningMsg() const { return msgSource().warningMsg(); }
         template <typename... Args> void warningMsg(Args &&...args) const {
             msgSource().warningMsg(std::forward<Args>(args)...);
         }
+        template <typename... Args>
+        void warningFmt(FormatString<Args...> fmt, Args &&...args) const {
+            msgSource().warningFmt(fmt, std::forward<Args>(args)...);
+        }
         MessageQueueStream errorMsg() const { return msgSource().errorMsg(); }
         template <typename... Args> void errorMsg(Args &&...args) const {
             msgSource().errorMsg(std::forward<Args>(args)...);
         }
+        template <typename... Args>
+        void errorFmt(FormatString<Args...> fmt, Args &&...args) const {
+            msgSource().errorFmt(fmt, std::forward<Args>(args)...);
+        }
         MessageQueueStream abortMsg() const { return msgSource().abortMsg(); }
         template <typename... Args> void abortMsg(Args &&...args) const {
             msgSource().abortMsg(std::forward<Args>(args)...);
         }
+        template <typename... Args>
+        void abortFmt(FormatString<Args...> fmt, Args &&...args) const {
+            msgSource().abortFmt(fmt, std::forward<Args>(args)...);
+        }
     };
 
     class MessageComponent : virtual public IMessageComponent {
@@ -4,6 +4,7 @@
 #include "AsyncQueue/Message.hxx"
 
 #include <chrono>
+#include <ctime>
 #include <functional>
 #include <iomanip>
 #include <sstream>
@@ -11,7 +12,14 @@
 #include <vector>
 
 namespace AsyncQueue {
-    /// @brief Basic implementation of a class that converts a message to a string to write
+    /**
+     * @brief Basic implementation of a class that converts a message to a string to write
+     *
+     * The field list is compiled into a render plan when the formatter is created. Each time field
+     * caches the text of the last second it rendered so that messages within the same second only
+     * recompute the sub-second digits. As the caches are updated when formatting, a formatter
+     * must not be used from more than one thread at once, though copies are independent.
+     */
     class MessageFormatter {
     public:
         /// @brief Different field types
@@ -41,6 +49,10 @@ namespace AsyncQueue {
          * @param sep A string that will be inserted between each non-empty field
          * @param repeatInfo If a message contains newlines, repeat the name, level and time strings
          *                   on the newline. If false the blankspace will still be kept.
+         *
+         * Each line of the message text is written on its own output line, with every message
+         * field replaced by that line. If there are no message fields only the other fields are
+         * written, on a single line.
          */
         MessageFormatter(
                 const std::vector<Field> &fields, const std::string &sep = " ",
@@ -49,6 +61,8 @@ namespace AsyncQueue {
         std::string operator()(const Message &message) { return format(message); }
         /// @brief Format the message
         std::string format(const Message &message) const;
+        /// @brief Format the message, appending the result to out
+        void format(const Message &message, std::string &out) const;
         /**
          * @brief Format an individual field
          * @param message The original message
@@ -73,39 +87,61 @@ namespace AsyncQueue {
         }
 
     private:
-        std::vector<Field> m_fields;
+        /// @brief A time format split around its sub-second codes
+        class TimeFormat {
+        public:
+            TimeFormat() = default;
+            TimeFormat(const std::string &format);
+            /// @brief Append the time to out, reusing the cached text if the second is unchanged
+            /// @param seconds The time in whole seconds
+            /// @param subSeconds The time since the start of the second
+            void append(
+                    std::string &out, std::time_t seconds,
+                    std::chrono::nanoseconds subSeconds) const;
+
+        private:
+            /// @brief The std::put_time formats between each sub-second code
+            std::vector<std::string> m_pieces;
+            /// @brief The sub-second codes, one fewer than the pieces
+            std::vector<char> m_codes;
+            mutable std::vector<std::string> m_cached;
+            mutable std::time_t m_cachedSeconds{0};
+            mutable bool m_cacheValid{false};
+        };
+
+        /// @brief A compiled field
+        struct Step {
+            FieldType type;
+            std::size_t minLength;
+            /// @brief The padded text of a literal field
+            std::string literal;
+            TimeFormat time;
+        };
+
+        /// @brief Compile a field into a step of the render plan
+        static Step compile(const Field &field);
+        /// @brief Append a non-message field to out
+        static void appendField(const Message &message, const Step &step, std::string &out);
+
+        std::vector<Step> m_plan;
+        std::size_t m_nMessageFields{0};
         std::string m_sep;
         bool m_repeatInfo;
+        /// @brief The rendered text between the message fields, reused between messages
+        mutable std::string m_segments;
+        /// @brief The end of each segment in m_segments
+        mutable std::vector<std::size_t> m_segmentEnds;
     };
 
     template <typename Clock>
     std::string MessageFormatter::formatTime(
             const std::chrono::time_point<Clock> &timepoint, std::string format) {
         auto seconds = std::chrono::floor<std::chrono::seconds>(timepoint);
-        if (format.find("%+") != std::string::npos) {
-            std::size_t pos = format.find("%+");
-            auto diff = timepoint - seconds;
-            while (pos != std::string::npos) {
-                if (pos + 2 >= format.size())
-                    break;
-                char code = format.at(pos + 2);
-                std::size_t count;
-                if (code == 'n')
-                    count = std::chrono::duration_cast<std::chrono::nanoseconds>(diff).count();
-                else if (code == 'u')
-                    count = std::chrono::duration_cast<std::chrono::microseconds>(diff).count();
-                else if (code == 'm')
-                    count = std::chrono::duration_cast<std::chrono::milliseconds>(diff).count();
-                else
-                    break;
-                format = format.replace(pos, 3, std::to_string(count));
-                pos = format.find("%+", pos);
-            }
-        }
-        std::ostringstream oss;
-        std::time_t tmt = Clock::to_time_t(seconds);
-        oss << std::put_time(std::localtime(&tmt), format.c_str());
-        return oss.str();
+        std::string value;
+        TimeFormat(format).append(
+                value, Clock::to_time_t(seconds),
+                std::chrono::duration_cast<std::chrono::nanoseconds>(timepoint - seconds));
+        return value;
     }
 } // namespace AsyncQueue
 
@@ -6,6 +6,8 @@
 #include "AsyncQueue/ManagedQueue.hxx"
 #include "AsyncQueue/Message.hxx"
 #include "AsyncQueue/MessageSource.hxx"
+#include "AsyncQueue/Overflow.hxx"
+#include "AsyncQueue/QueueStats.hxx"
 
 #include <concepts>
 #include <future>
@@ -36,6 +38,19 @@ namespace AsyncQueue {
         MessageLevel defaultOutputLevel() const { return m_defaultOutputLevel; }
         void setDefaultOutputLevel(MessageLevel lvl) { m_defaultOutputLevel = lvl; }
 
+        /// @brief Bound the number of queued messages, see AsyncQueue::setCapacity
+        void setCapacity(std::size_t capacity, OverflowPolicy policy = OverflowPolicy::Block) {
+            m_queue.setCapacity(capacity, policy);
+        }
+        /// @brief Bound the number of queued messages, discarding those below dropBelow when full
+        void setCapacity(std::size_t capacity, MessageLevel dropBelow) {
+            m_queue.setCapacity(capacity, dropBelow);
+        }
+        /// @brief The number of messages discarded because the queue was full
+        DropCounts dropCounts() const { return m_queue.dropCounts(); }
+        /// @brief Statistics of the message queue and writer, see ManagedQueue::stats
+        QueueStats stats() const { return m_queue.stats(); }
+
         MessageSource createSource(const std::string &name);
         MessageSource createSource(const std::string &name, MessageLevel lvl);
 
@@ -2,17 +2,22 @@
 #define ASYNCQUEUE_MESSAGEQUEUEBUFFER_HXX
 
 #include "AsyncQueue/Message.hxx"
+#include "AsyncQueue/SourceRegistry.hxx"
 
-#include <sstream>
+#include <streambuf>
+#include <string>
+#ifdef AsyncQueue_MULTITHREAD
+#include <stop_token>
+#endif
 
 namespace AsyncQueue {
     /// @brief Message buffer class
     ///
-    /// Acts as a basic wrapper around a stringbuf that sends completed messages to the wrapped
-    /// queue on a flush. If there is no associated queue this buffer does essentially nothing.
-    /// However this is likely to be inefficient as all the work to format the strings is still
-    /// done.
-    class MessageQueueBuffer : public std::stringbuf {
+    /// Stream buffer that sends completed messages to the wrapped queue on a flush. Characters are
+    /// written directly into a string taken from the MessageText pool, which is then moved into
+    /// the message, so building a message does not allocate once the pool has warmed up. If there
+    /// is no associated queue all input characters are discarded.
+    class MessageQueueBuffer : public std::streambuf {
     public:
         /// @brief Create an invalid buffer. All input characters will be ignored
         MessageQueueBuffer();
@@ -21,18 +26,38 @@ namespace AsyncQueue {
         /// @param queue The queue to write to
         /// @param lvl The message level for each message
         /// @param source The name of the message source
-        MessageQueueBuffer(MessageQueue &queue, MessageLevel lvl, const std::string &source);
+        MessageQueueBuffer(MessageQueue &queue, MessageLevel lvl, SourceName source);
+#ifdef AsyncQueue_MULTITHREAD
+        /// @brief Create the buffer
+        /// @param queue The queue to write to
+        /// @param lvl The message level for each message
+        /// @param source The name of the message source
+        /// @param st Once this is stopped messages are discarded rather than waiting for space in
+        ///        a full queue
+        MessageQueueBuffer(
+                MessageQueue &queue, MessageLevel lvl, SourceName source, std::stop_token st);
+#endif
 
         MessageQueueBuffer(MessageQueueBuffer &&other);
+        ~MessageQueueBuffer();
 
     protected:
         int sync() override;
+        int_type overflow(int_type ch) override;
 
     private:
+        /// @brief Point the put area at the unused part of m_text, keeping used characters
+        void resetPutArea(std::size_t used);
+
         MessageQueue *m_queue{nullptr};
         const MessageLevel m_lvl{MessageLevel::ABORT};
-        const std::string m_source;
+        const SourceName m_source;
+#ifdef AsyncQueue_MULTITHREAD
+        std::stop_token m_stopToken;
+#endif
+        /// @brief Storage for the put area. Its size is the capacity available for writing
+        std::string m_text;
     };
 } // namespace AsyncQueue
 
-#endif //> !ASYNCQUEUE_MESSAGEQUEUEBUFFER_HXX
\ No newline at end of file
+#endif //> !ASYNCQUEUE_MESSAGEQUEUEBUFFER_HXX
@@ -10,7 +10,11 @@ namespace AsyncQueue {
     class MessageQueueStream : public std::ostream {
     public:
         MessageQueueStream();
-        MessageQueueStream(MessageQueue &queue, MessageLevel lvl, const std::string &source);
+        MessageQueueStream(MessageQueue &queue, MessageLevel lvl, SourceName source);
+#ifdef AsyncQueue_MULTITHREAD
+        MessageQueueStream(
+                MessageQueue &queue, MessageLevel lvl, SourceName source, std::stop_token st);
+#endif
         MessageQueueStream(MessageQueueStream &&other);
         ~MessageQueueStream();
 
@@ -1,13 +1,19 @@
 #ifndef ASYNCQUEUE_MESSAGESOURCE_HXX
 #define ASYNCQUEUE_MESSAGESOURCE_HXX
 
+#include "AsyncQueue/Format.hxx"
 #include "AsyncQueue/Fwd.hxx"
 #include "AsyncQueue/Message.hxx"
 #include "AsyncQueue/MessageQueueStream.hxx"
+#include "AsyncQueue/SourceRegistry.hxx"
 
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
+#ifdef AsyncQueue_MULTITHREAD
+#include <stop_token>
+#endif
 
 namespace AsyncQueue {
     /// @brief Thread-safe source of messages
@@ -15,6 +21,17 @@ namespace AsyncQueue {
     /// Behaves similar to an output stream. The first thing passed to it must be a level which
     /// triggers the crreation of a MessageQueueStream which handles the creation of the messages.
     /// When the builder goes out of scope all messages it contains are pushed to the queue.
+    ///
+    /// The name is interned in the SourceRegistry when the source is created so copying the
+    /// source, or creating a message from it, does not copy the name. Names are kept for the life
+    /// of the program, so they should come from a small fixed set rather than, for example,
+    /// include a request ID. See SourceRegistry for what happens once it is full.
+    ///
+    /// The Fmt helpers take a std::format style string and capture the arguments by value. The
+    /// text is only formatted when a writer accesses it on the consumer thread. Messages below
+    /// AsyncQueue_MIN_LEVEL are removed at compile time by the level specific helpers and the
+    /// ASYNCQUEUE_LOG macros, which also skip evaluating their arguments. Streams begun below it
+    /// are inert and discard anything written to them.
     class MessageSource {
     public:
         /// @brief Create the source
@@ -25,6 +42,19 @@ namespace AsyncQueue {
         MessageSource(
                 const std::string &name, MessageQueue &queue,
                 MessageLevel lvl = MessageLevel::INFO);
+#ifdef AsyncQueue_MULTITHREAD
+        /// @brief Create the source
+        /// @param name The name of the source, can be included in messages
+        /// @param queue The message queue to use
+        /// @param lvl The output level. Only messages with a greater or equal severity will be
+        /// output
+        /// @param st Once this is stopped messages are discarded rather than pushed. Pass the
+        ///        closedToken of the ManagedQueue which consumes the queue, so that a source never
+        ///        waits on a full queue which will not be drained
+        MessageSource(
+                const std::string &name, MessageQueue &queue, MessageLevel lvl,
+                std::stop_token st);
+#endif
 
         /// @brief Create a new subsource
         /// @param subName The name of the new source will be "<our name>:<subName>"
@@ -39,54 +69,175 @@ namespace AsyncQueue {
         /// @brief Create a subsource named after the current thread
         MessageSource createThreadSubSource() const;
 
+        /// @brief The name of the source
+        std::string_view name() const { return m_name; }
+        /// @brief The ID of the name in the SourceRegistry
+        SourceId sourceId() const { return m_name.id(); }
+
         /// @brief Begin a message of the specified severity
         MessageQueueStream operator<<(MessageLevel lvl) const { return msg(lvl); }
         /// @brief The output level
         MessageLevel outputLevel() const { return m_outputLvl; }
         /// @brief Should we output a message of this severity?
-        bool testLevel(MessageLevel level) const { return m_outputLvl <= level; }
+        bool testLevel(MessageLevel level) const {
+            return isCompiledIn(level) && m_outputLvl <= level;
+        }
         /// @brief Begin a message of the specified severity
-        MessageQueueStream msg(MessageLevel lvl) const;
+        ///
+        /// The stream discards its input if the level is below AsyncQueue_MIN_LEVEL or the output
+        /// level of this source.
+        MessageQueueStream msg(MessageLevel lvl) const {
+            if (!isCompiledIn(lvl))
+                return MessageQueueStream();
+            return stream(lvl);
+        }
+        /// @brief Create a message from a format string and arguments
+        /// @param lvl The message level
+        /// @param fmt The format string, checked against the arguments at compile time
+        /// @param args The arguments, captured by value and formatted by the consumer
+        template <typename... Args>
+        void fmtMsg(MessageLevel lvl, FormatString<Args...> fmt, Args &&...args) const {
+            if (testLevel(lvl))
+                push(lvl, MessageText(detail::makeDeferredFormat(
+                                  fmt.get(), std::forward<Args>(args)...)));
+        }
         /// @name Message helpers
         /// Helper functions to produce specific message levels
         /// @{
-        MessageQueueStream verboseMsg() const { return msg(MessageLevel::VERBOSE); }
+        MessageQueueStream verboseMsg() const {
+            if constexpr (isCompiledIn(MessageLevel::VERBOSE))
+                return stream(MessageLevel::VERBOSE);
+            else
+                return MessageQueueStream();
+        }
         template <typename... Args> void verboseMsg(Args &&...args) const {
-            if (testLevel(MessageLevel::VERBOSE))
-                (verboseMsg() << ... << args);
+            if constexpr (isCompiledIn(MessageLevel::VERBOSE))
+                if (testLevel(MessageLevel::VERBOSE))
+                    (verboseMsg() << ... << args);
+        }
+        template <typename... Args>
+        void verboseFmt(FormatString<Args...> fmt, Args &&...args) const {
+            if constexpr (isCompiledIn(MessageLevel::VERBOSE))
+                fmtMsg(MessageLevel::VERBOSE, fmt, std::forward<Args>(args)...);
+        }
+        MessageQueueStream debugMsg() const {
+            if constexpr (isCompiledIn(MessageLevel::DEBUG))
+                return stream(MessageLevel::DEBUG);
+            else
+                return MessageQueueStream();
         }
-        MessageQueueStream debugMsg() const { return msg(MessageLevel::DEBUG); }
         template <typename... Args> void debugMsg(Args &&...args) const {
-            if (testLevel(MessageLevel::DEBUG))
-                (debugMsg() << ... << args);
+            if constexpr (isCompiledIn(MessageLevel::DEBUG))
+                if (testLevel(MessageLevel::DEBUG))
+                    (debugMsg() << ... << args);
+        }
+        template <typename... Args>
+        void debugFmt(FormatString<Args...> fmt, Args &&...args) const {
+            if constexpr (isCompiledIn(MessageLevel::DEBUG))
+                fmtMsg(MessageLevel::DEBUG, fmt, std::forward<Args>(args)...);
+        }
+        MessageQueueStream infoMsg() const {
+            if constexpr (isCompiledIn(MessageLevel::INFO))
+                return stream(MessageLevel::INFO);
+            else
+                return MessageQueueStream();
         }
-        MessageQueueStream infoMsg() const { return msg(MessageLevel::INFO); }
         template <typename... Args> void infoMsg(Args &&...args) const {
-            if (testLevel(MessageLevel::INFO))
-                (infoMsg() << ... << args);
+            if constexpr (isCompiledIn(MessageLevel::INFO))
+                if (testLevel(MessageLevel::INFO))
+                    (infoMsg() << ... << args);
+        }
+        template <typename... Args>
+        void infoFmt(FormatString<Args...> fmt, Args &&...args) const {
+            if constexpr (isCompiledIn(MessageLevel::INFO))
+                fmtMsg(MessageLevel::INFO, fmt, std::forward<Args>(args)...);
+        }
+        MessageQueueStream warningMsg() const {
+            if constexpr (isCompiledIn(MessageLevel::WARNING))
+                return stream(MessageLevel::WARNING);
+            else
+                return MessageQueueStream();
         }
-        MessageQueueStream warningMsg() const { return msg(MessageLevel::WARNING); }
         template <typename... Args> void warningMsg(Args &&...args) const {
-            if (testLevel(MessageLevel::WARNING))
-                (warningMsg() << ... << args);
+            if constexpr (isCompiledIn(MessageLevel::WARNING))
+                if (testLevel(MessageLevel::WARNING))
+                    (warningMsg() << ... << args);
+        }
+        template <typename... Args>
+        void warningFmt(FormatString<Args...> fmt, Args &&...args) const {
+            if constexpr (isCompiledIn(MessageLevel::WARNING))
+                fmtMsg(MessageLevel::WARNING, fmt, std::forward<Args>(args)...);
+        }
+        MessageQueueStream errorMsg() const {
+            if constexpr (isCompiledIn(MessageLevel::ERROR))
+                return stream(MessageLevel::ERROR);
+            else
+                return MessageQueueStream();
         }
-        MessageQueueStream errorMsg() const { return msg(MessageLevel::ERROR); }
         template <typename... Args> void errorMsg(Args &&...args) const {
-            if (testLevel(MessageLevel::ERROR))
-                (errorMsg() << ... << args);
+            if constexpr (isCompiledIn(MessageLevel::ERROR))
+                if (testLevel(MessageLevel::ERROR))
+                    (errorMsg() << ... << args);
+        }
+        template <typename... Args>
+        void errorFmt(FormatString<Args...> fmt, Args &&...args) const {
+            if constexpr (isCompiledIn(MessageLevel::ERROR))
+                fmtMsg(MessageLevel::ERROR, fmt, std::forward<Args>(args)...);
+        }
+        MessageQueueStream abortMsg() const {
+            if constexpr (isCompiledIn(MessageLevel::ABORT))
+                return stream(MessageLevel::ABORT);
+            else
+                return MessageQueueStream();
         }
-        MessageQueueStream abortMsg() const { return msg(MessageLevel::ABORT); }
         template <typename... Args> void abortMsg(Args &&...args) const {
-            if (testLevel(MessageLevel::ABORT))
-                (abortMsg() << ... << args);
+            if constexpr (isCompiledIn(MessageLevel::ABORT))
+                if (testLevel(MessageLevel::ABORT))
+                    (abortMsg() << ... << args);
+        }
+        template <typename... Args>
+        void abortFmt(FormatString<Args...> fmt, Args &&...args) const {
+            if constexpr (isCompiledIn(MessageLevel::ABORT))
+                fmtMsg(MessageLevel::ABORT, fmt, std::forward<Args>(args)...);
         }
         /// @}
 
     private:
+        /// @brief Begin a message which has passed the compile time level check
+        MessageQueueStream stream(MessageLevel lvl) const;
+        /// @brief Push a completed message to the queue
+        void push(MessageLevel lvl, MessageText &&text) const;
+
         MessageQueue &m_queue;
-        const std::string m_name;
+        const SourceName m_name;
         const MessageLevel m_outputLvl;
+#ifdef AsyncQueue_MULTITHREAD
+        std::stop_token m_stopToken;
+#endif
     };
 } // namespace AsyncQueue
 
+/// @brief Log a formatted message, e.g. ASYNCQUEUE_LOG(source, MessageLevel::INFO, "{}", x)
+///
+/// The level must be a constant expression. If it is below AsyncQueue_MIN_LEVEL the statement is
+/// removed at compile time, and the arguments are only evaluated if the source outputs the level.
+#define ASYNCQUEUE_LOG(source, lvl, ...)                                                          \
+    do {                                                                                           \
+        if constexpr (::AsyncQueue::isCompiledIn(lvl))                                             \
+            if ((source).testLevel(lvl))                                                           \
+                (source).fmtMsg(lvl, __VA_ARGS__);                                                 \
+    } while (false)
+#define ASYNCQUEUE_VERBOSE(source, ...)                                                           \
+    ASYNCQUEUE_LOG(source, ::AsyncQueue::MessageLevel::VERBOSE, __VA_ARGS__)
+#define ASYNCQUEUE_DEBUG(source, ...)                                                             \
+    ASYNCQUEUE_LOG(source, ::AsyncQueue::MessageLevel::DEBUG, __VA_ARGS__)
+#define ASYNCQUEUE_INFO(source, ...)                                                              \
+    ASYNCQUEUE_LOG(source, ::AsyncQueue::MessageLevel::INFO, __VA_ARGS__)
+#define ASYNCQUEUE_WARNING(source, ...)                                                           \
+    ASYNCQUEUE_LOG(source, ::AsyncQueue::MessageLevel::WARNING, __VA_ARGS__)
+#define ASYNCQUEUE_ERROR(source, ...)                                                             \
+    ASYNCQUEUE_LOG(source, ::AsyncQueue::MessageLevel::ERROR, __VA_ARGS__)
+#define ASYNCQUEUE_ABORT(source, ...)                                                             \
+    ASYNCQUEUE_LOG(source, ::AsyncQueue::MessageLevel::ABORT, __VA_ARGS__)
+
 #endif //> !ASYNCQUEUE_MESSAGESOURCE_HXX
\ No newline at end of file
@@ -2,11 +2,14 @@
 #define ASYNCQUEUE_MESSAGEWRITER_HXX
 
 #include "AsyncQueue/Fwd.hxx"
-#include "AsyncQueue/IConsumer.hxx"
+#include "AsyncQueue/IBatchConsumer.hxx"
 #include "AsyncQueue/Message.hxx"
+#include "AsyncQueue/MessageFormatter.hxx"
 
 #include <functional>
+#include <optional>
 #include <ostream>
+#include <span>
 #include <string>
 
 namespace AsyncQueue {
@@ -15,8 +18,11 @@ namespace AsyncQueue {
      *
      * Note that this class is not threadsafe - it should only run in *one* thread.
      * Making it fully threadsafe would require C++20 syncstream.
+     *
+     * Each batch of messages is written to the stream in one go. Messages created from a format
+     * string are formatted here, on the consumer thread, and only if they pass the level filter.
      */
-    class MessageWriter : public IMessageWriter {
+    class MessageWriter : public IBatchConsumer<Message> {
     public:
         /// @brief Function type converting a message to a string representation
         using formatter_t = std::function<std::string(const Message &)>;
@@ -30,13 +36,24 @@ namespace AsyncQueue {
         /// @param lvl Only write messages at or above this level
         MessageWriter(
                 std::ostream &os, formatter_t format, MessageLevel lvl = MessageLevel::VERBOSE);
+        /// @brief Create the writer
+        /// @param os The stream to write to
+        /// @param formatter Formatter which appends each message to a reused buffer
+        /// @param lvl Only write messages at or above this level
+        MessageWriter(
+                std::ostream &os, MessageFormatter formatter,
+                MessageLevel lvl = MessageLevel::VERBOSE);
 
-        TaskStatus consume(const Message &message) override;
+        using IBatchConsumer<Message>::consume;
+        TaskStatus consume(std::span<const Message> messages) override;
 
     private:
         std::ostream &m_os;
         MessageLevel m_lvl;
         formatter_t m_format;
+        std::optional<MessageFormatter> m_formatter;
+        /// @brief The formatted text of the current batch
+        std::string m_buffer;
     };
 } // namespace AsyncQueue
 
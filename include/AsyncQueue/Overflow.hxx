@@ -0,0 +1,54 @@
+/**
+ * @file Overflow.hxx
+ * @brief Policies describing what a bounded queue does when it is full
+ */
+
+#ifndef ASYNCQUEUE_OVERFLOW_HXX
+#define ASYNCQUEUE_OVERFLOW_HXX
+
+#include "AsyncQueue/Fwd.hxx"
+
+#include <concepts>
+#include <cstddef>
+
+namespace AsyncQueue {
+    /// @brief What a bounded queue does with an element pushed while it is full
+    enum class OverflowPolicy {
+        /// @brief Block the producer until there is space or its stop token is stopped
+        Block,
+        /// @brief Discard the element being pushed
+        DropNewest,
+        /// @brief Discard the element at the front of the queue to make space
+        DropOldest,
+        /// @brief Discard the element being pushed if its message level is below a threshold,
+        /// otherwise block as for OverflowPolicy::Block. Only available for elements which have a
+        /// message level
+        DropBelowLevel
+    };
+
+    /// @brief Counts of elements that a bounded queue has discarded
+    struct DropCounts {
+        /// @brief Pushed elements discarded by OverflowPolicy::DropNewest
+        std::size_t newest{0};
+        /// @brief Queued elements discarded by OverflowPolicy::DropOldest
+        std::size_t oldest{0};
+        /// @brief Pushed elements discarded by OverflowPolicy::DropBelowLevel
+        std::size_t belowLevel{0};
+        /// @brief Blocked pushes abandoned because a stop was requested
+        std::size_t interrupted{0};
+
+        /// @brief The total number of elements that were not delivered
+        std::size_t total() const { return newest + oldest + belowLevel + interrupted; }
+    };
+
+    namespace concepts {
+        /// @brief Concept satisfied by queues with a configurable capacity and overflow policy
+        template <typename Q>
+        concept BoundedQueue = requires(Q &q, const Q &cq, std::size_t n, OverflowPolicy p) {
+            q.setCapacity(n, p);
+            { cq.dropCounts() } -> std::same_as<DropCounts>;
+        };
+    } // namespace concepts
+} // namespace AsyncQueue
+
+#endif //> !ASYNCQUEUE_OVERFLOW_HXX
@@ -0,0 +1,112 @@
+/**
+ * @file QueueStats.hxx
+ * @brief Optional instrumentation of queues and their consumers
+ *
+ * Statistics are only collected when the library is built with AsyncQueue_INSTRUMENT defined
+ * (the CMake option of the same name). Otherwise queues keep no extra state, do no extra work and
+ * their stats methods return an empty snapshot.
+ */
+
+#ifndef ASYNCQUEUE_QUEUESTATS_HXX
+#define ASYNCQUEUE_QUEUESTATS_HXX
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace AsyncQueue {
+    /// @brief Whether queues collect statistics
+#ifdef AsyncQueue_INSTRUMENT
+    constexpr inline bool queueInstrumentation = true;
+#else
+    constexpr inline bool queueInstrumentation = false;
+#endif
+
+    /**
+     * @brief Histogram of durations with logarithmically sized buckets
+     *
+     * Durations are recorded in nanoseconds. Below subBuckets nanoseconds every value has its own
+     * bucket, above that each power of two is split into subBuckets equal buckets, so percentiles
+     * are within 1/subBuckets of the recorded values while covering the full range of the type.
+     */
+    class LatencyHistogram {
+    public:
+        using duration = std::chrono::nanoseconds;
+
+        /// @brief log2 of the number of buckets each power of two is split into
+        static constexpr unsigned subBucketBits = 3;
+        /// @brief The number of buckets each power of two is split into
+        static constexpr std::size_t subBuckets = std::size_t{1} << subBucketBits;
+        /// @brief The total number of buckets, enough for any non-negative 64-bit count
+        static constexpr std::size_t nBuckets = (63 - subBucketBits + 1) * subBuckets;
+
+        /// @brief Record a single duration. Negative durations are recorded as zero
+        void record(duration d);
+
+        /// @brief Add the contents of another histogram to this
+        LatencyHistogram &operator+=(const LatencyHistogram &other);
+
+        /// @brief Remove all recorded durations
+        void clear();
+
+        /// @brief The number of recorded durations
+        std::uint64_t count() const { return m_count; }
+
+        /// @brief The smallest recorded duration, zero if the histogram is empty
+        duration min() const;
+
+        /// @brief The largest recorded duration, zero if the histogram is empty
+        duration max() const { return duration(m_max); }
+
+        /// @brief The mean of the recorded durations, zero if the histogram is empty
+        duration mean() const;
+
+        /**
+         * @brief Estimate a percentile of the recorded durations
+         * @param percent The percentile to estimate, between 0 and 100
+         * @return The upper bound of the bucket containing the percentile, limited to the range of
+         *         recorded values. Zero if the histogram is empty
+         */
+        duration percentile(double percent) const;
+
+        /// @brief The number of durations in a bucket
+        std::uint64_t bucketCount(std::size_t index) const { return m_buckets[index]; }
+
+        /// @brief The smallest duration in a bucket
+        static duration bucketLowerBound(std::size_t index);
+
+        /// @brief The largest duration in a bucket
+        static duration bucketUpperBound(std::size_t index);
+
+        /// @brief The bucket that a duration is recorded in
+        static std::size_t bucketIndex(duration d);
+
+    private:
+        std::array<std::uint64_t, nBuckets> m_buckets{};
+        std::uint64_t m_count{0};
+        /// @brief Sum of the recorded durations in nanoseconds, used for the mean
+        std::uint64_t m_sum{0};
+        std::uint64_t m_min{0};
+        std::uint64_t m_max{0};
+    };
+
+    /// @brief Snapshot of the statistics collected by a queue
+    struct QueueStats {
+        /// @brief Elements accepted by the queue
+        std::uint64_t enqueued{0};
+        /// @brief Elements extracted from the queue. Elements discarded by the overflow policy
+        ///        after being accepted are counted in DropCounts::oldest instead
+        std::uint64_t dequeued{0};
+        /// @brief The largest number of elements held by the queue at once
+        std::size_t highWaterMark{0};
+        /// @brief The number of times a thread had to wait to acquire the queue's lock
+        std::uint64_t contended{0};
+        /// @brief Time from each element being pushed to it being extracted
+        LatencyHistogram latency;
+        /// @brief Time spent in each call to the consumer. Only filled by a ManagedQueue
+        LatencyHistogram serviceTime;
+    };
+} // namespace AsyncQueue
+
+#endif //> !ASYNCQUEUE_QUEUESTATS_HXX
@@ -0,0 +1,292 @@
+/**
+ * @file RingBufferQueue.hxx
+ * @brief Bounded, lock-free alternative to AsyncQueue
+ */
+
+#ifdef AsyncQueue_MULTITHREAD
+#ifndef ASYNCQUEUE_RINGBUFFERQUEUE_HXX
+#define ASYNCQUEUE_RINGBUFFERQUEUE_HXX
+
+#include "AsyncQueue/AsyncQueue.hxx"
+#include "AsyncQueue/Batch.hxx"
+#include "AsyncQueue/Loop.hxx"
+#include "AsyncQueue/TaskStatus.hxx"
+#include "AsyncQueue/concepts.hxx"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <stop_token>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace AsyncQueue {
+    /// @brief The concurrency model supported by a RingBufferQueue
+    enum class RingBufferMode {
+        /// @brief Exactly one thread pushes and exactly one thread extracts
+        SPSC,
+        /// @brief Any number of threads may push and extract
+        MPMC
+    };
+
+    namespace detail {
+        /// @brief Size used to keep independently written atomics on separate cache lines
+        static constexpr inline std::size_t cacheLineSize = 64;
+    } // namespace detail
+
+    /**
+     * @brief Fixed capacity queue implemented as a lock-free ring buffer
+     * @tparam T The data type stored in the queue
+     * @tparam Capacity The maximum number of elements in the queue. Must be a power of two
+     * @tparam Mode Whether the queue supports one or many producers and consumers
+     *
+     * Pushing and extracting never take a lock. Threads are only parked (on a condition variable)
+     * when a consumer waits on an empty queue or a producer waits on a full one, and the other side
+     * only touches the mutex when it knows that a thread is parked.
+     *
+     * The interface mirrors AsyncQueue, minus the lock overloads, so the queue can be used with
+     * loopProducer, loopConsumer and ManagedQueue in the same way. In SPSC mode it is the caller's
+     * responsibility to ensure that only one thread pushes and one thread extracts.
+     *
+     * If copying or moving an element into the queue throws, the exception is propagated to the
+     * producer and the element is not pushed.
+     */
+    template <typename T, std::size_t Capacity, RingBufferMode Mode = RingBufferMode::MPMC>
+    class RingBufferQueue {
+        static_assert(
+                Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "RingBufferQueue capacity must be a power of two");
+
+    public:
+        using value_type = T;
+
+        RingBufferQueue();
+        ~RingBufferQueue();
+        RingBufferQueue(const RingBufferQueue &) = delete;
+        RingBufferQueue &operator=(const RingBufferQueue &) = delete;
+
+        /// @brief The maximum number of elements the queue can hold
+        static constexpr std::size_t capacity() { return Capacity; }
+
+        /// @name Push methods
+        /// The push methods take a const reference (copy) or an rvalue reference (move) to a value
+        /// to add to the queue. The tryPush methods return false immediately if the queue is full.
+        /// The other versions block until there is space, or until the stop token (if provided) is
+        /// stopped in which case false is returned.
+        /// @{
+        bool tryPush(const T &value);
+        bool tryPush(T &&value);
+        void push(const T &value);
+        bool push(const T &value, std::stop_token st);
+        void push(T &&value);
+        bool push(T &&value, std::stop_token st);
+        /// @}
+
+        /// @name Bulk push methods
+        /// Push several values, blocking whenever the queue is full. pushRange copies each element
+        /// of the range, pushBulk moves the elements out of the provided vector. The versions
+        /// taking a stop token give up if it is stopped. Returns the number of elements accepted.
+        /// @{
+        template <std::input_iterator It, std::sentinel_for<It> S>
+        std::size_t pushRange(It first, S last);
+        template <std::input_iterator It, std::sentinel_for<It> S>
+        std::size_t pushRange(It first, S last, std::stop_token st);
+        template <std::ranges::input_range R> std::size_t pushRange(R &&range);
+        std::size_t pushBulk(std::vector<T> &&values);
+        std::size_t pushBulk(std::vector<T> &&values, std::stop_token st);
+        /// @}
+
+        /**
+         * @brief Extract the first element of the queue
+         *
+         * The element is removed from the queue and returned. If the queue is empty the optional
+         * will not be filled. Never blocks.
+         */
+        std::optional<T> extract();
+
+        /**
+         * @brief Extract up to maxCount elements from the front of the queue
+         *
+         * The elements are removed from the queue and appended to out in queue order. Never blocks
+         *
+         * @param out The vector to fill
+         * @param maxCount The maximum number of elements to extract
+         * @return The number of elements extracted
+         */
+        std::size_t extractBatch(std::vector<T> &out, std::size_t maxCount);
+
+        /// @brief Get the number of elements in the queue
+        ///
+        /// In the presence of concurrent pushes and extractions this is only a snapshot.
+        std::size_t size() const;
+
+        /// @brief Is the queue empty?
+        bool empty() const;
+
+        /// @brief Is the queue full?
+        bool full() const;
+
+        /**
+         * @brief Block until the queue contains an element or a stop is requested
+         * @param st The stop token which interrupts the wait
+         * @return Whether the queue is non-empty
+         */
+        bool waitForElement(std::stop_token st);
+
+        /**
+         * @brief Block until the queue contains at least count elements
+         * @param st The stop token which interrupts the wait
+         * @param count The number of elements to wait for
+         * @param deadline The latest time to wait until
+         * @return Whether the queue contains at least count elements
+         */
+        bool waitForElements(
+                std::stop_token st, std::size_t count,
+                const std::chrono::steady_clock::time_point &deadline);
+
+        template <typename F, typename... Args>
+            requires QueueProducer<F, RingBufferQueue, Args...>
+        std::future<TaskStatus> loopProducer(std::stop_source ss, F &&f, Args &&...args) {
+            return loop(ss, std::forward<F>(f), std::ref(*this), std::forward<Args>(args)...);
+        }
+
+        template <concepts::Duration D, typename F, typename... Args>
+            requires QueueProducer<F, RingBufferQueue, Args...>
+        std::future<TaskStatus> loopProducer(
+                std::stop_source ss, const D &d, F &&f, Args &&...args) {
+            return loop(ss, d, std::forward<F>(f), std::ref(*this), std::forward<Args>(args)...);
+        }
+
+        template <typename F, typename... Args>
+            requires Consumer<F, T, Args...>
+        std::future<TaskStatus> loopConsumer(std::stop_source ss, F &&f, Args &&...args);
+
+        /// @brief Loop a consumer which only accepts batches of elements
+        template <typename F, typename... Args>
+            requires(!Consumer<F, T, Args...>) && BatchConsumer<F, T, Args...>
+        std::future<TaskStatus> loopConsumer(std::stop_source ss, F &&f, Args &&...args) {
+            return loopConsumer(
+                    ss, BatchOptions{}, std::forward<F>(f), std::forward<Args>(args)...);
+        }
+
+        /// @brief Loop a consumer, passing it batches of elements
+        template <typename F, typename... Args>
+            requires BatchConsumer<F, T, Args...>
+        std::future<TaskStatus> loopConsumer(
+                std::stop_source ss, const BatchOptions &options, F &&f, Args &&...args);
+
+        /// @name Executor overloads
+        /// Run the producer or consumer on a shared executor, see AsyncQueue
+        /// @{
+        template <typename F, typename... Args>
+            requires QueueProducer<F, RingBufferQueue, Args...>
+        std::future<TaskStatus> loopProducer(
+                Executor &executor, std::stop_source ss, F &&f, Args &&...args) {
+            return loop(
+                    executor, ss, std::forward<F>(f), std::ref(*this),
+                    std::forward<Args>(args)...);
+        }
+
+        template <concepts::Duration D, typename F, typename... Args>
+            requires QueueProducer<F, RingBufferQueue, Args...>
+        std::future<TaskStatus> loopProducer(
+                Executor &executor, std::stop_source ss, const D &d, F &&f, Args &&...args) {
+            return loop(
+                    executor, ss, d, std::forward<F>(f), std::ref(*this),
+                    std::forward<Args>(args)...);
+        }
+
+        template <typename F, typename... Args>
+            requires Consumer<F, T, Args...>
+        std::future<TaskStatus> loopConsumer(
+                Executor &executor, std::stop_source ss, F &&f, Args &&...args);
+
+        template <typename F, typename... Args>
+            requires(!Consumer<F, T, Args...>) && BatchConsumer<F, T, Args...>
+        std::future<TaskStatus> loopConsumer(
+                Executor &executor, std::stop_source ss, F &&f, Args &&...args) {
+            return loopConsumer(
+                    executor, ss, BatchOptions{}, std::forward<F>(f),
+                    std::forward<Args>(args)...);
+        }
+
+        template <typename F, typename... Args>
+            requires BatchConsumer<F, T, Args...>
+        std::future<TaskStatus> loopConsumer(
+                Executor &executor, std::stop_source ss, const BatchOptions &options, F &&f,
+                Args &&...args);
+        /// @}
+
+        /**
+         * @brief Call a function once the queue contains an element
+         *
+         * If the queue is already non-empty the callback is called immediately, otherwise it is
+         * called by the next push, on the pushing thread. The callback must therefore be short.
+         */
+        void onElementReady(std::function<void()> callback);
+
+    private:
+        static constexpr std::size_t mask = Capacity - 1;
+
+        /// @brief Storage for a single element
+        struct Slot {
+            alignas(T) unsigned char storage[sizeof(T)];
+            T *get() { return std::launder(reinterpret_cast<T *>(storage)); }
+        };
+        /// @brief Storage for a single element with the sequence number used in MPMC mode
+        struct SequencedSlot : Slot {
+            std::atomic<std::size_t> sequence;
+            /// @brief Set if the element's constructor threw after the slot was claimed. The slot
+            /// is published without an element and skipped by the consumer
+            bool tombstone{false};
+        };
+        using slot_t = std::conditional_t<Mode == RingBufferMode::MPMC, SequencedSlot, Slot>;
+
+        template <typename U> bool tryEmplace(U &&value);
+        template <typename U> bool waitAndEmplace(U &&value, std::stop_token st);
+        bool waitForSpace(std::stop_token st);
+        void notifyConsumers();
+        void notifyProducers();
+
+        std::unique_ptr<slot_t[]> m_slots;
+        // Each cache sits on the same line as the index written by its owner, so that neither
+        // side's fast path touches a line written by the other
+        /// @brief Index of the next element to extract
+        alignas(detail::cacheLineSize) std::atomic<std::size_t> m_head{0};
+        /// @brief Consumer's cached copy of m_tail (SPSC only)
+        std::size_t m_tailCache{0};
+        /// @brief Index of the next element to push
+        alignas(detail::cacheLineSize) std::atomic<std::size_t> m_tail{0};
+        /// @brief Producer's cached copy of m_head (SPSC only)
+        std::size_t m_headCache{0};
+        /// @brief Slow path used to park threads
+        alignas(detail::cacheLineSize) std::mutex m_waitMutex;
+        std::condition_variable_any m_notEmpty;
+        std::condition_variable_any m_notFull;
+        std::atomic<std::size_t> m_waitingConsumers{0};
+        std::atomic<std::size_t> m_waitingProducers{0};
+        /// @brief Callbacks registered by onElementReady, each counts as a waiting consumer
+        std::vector<std::function<void()>> m_readyCallbacks;
+    }; //> end class RingBufferQueue<T, Capacity, Mode>
+
+    /// @brief Lock-free queue with a single producer and single consumer
+    template <typename T, std::size_t Capacity>
+    using SPSCQueue = RingBufferQueue<T, Capacity, RingBufferMode::SPSC>;
+
+    /// @brief Lock-free queue with multiple producers and consumers
+    template <typename T, std::size_t Capacity>
+    using MPMCQueue = RingBufferQueue<T, Capacity, RingBufferMode::MPMC>;
+} // namespace AsyncQueue
+
+#include "AsyncQueue/RingBufferQueue.ixx"
+
+#endif //> !ASYNCQUEUE_RINGBUFFERQUEUE_HXX
+#endif //> AsyncQueue_MULTITHREAD
@@ -0,0 +1,406 @@
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+namespace AsyncQueue {
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    RingBufferQueue<T, Capacity, Mode>::RingBufferQueue()
+            : m_slots(std::make_unique<slot_t[]>(Capacity)) {
+        if constexpr (Mode == RingBufferMode::MPMC)
+            for (std::size_t idx = 0; idx < Capacity; ++idx)
+                m_slots[idx].sequence.store(idx, std::memory_order_relaxed);
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    RingBufferQueue<T, Capacity, Mode>::~RingBufferQueue() {
+        // Destroy any elements which were never extracted
+        while (extract())
+            ;
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    bool RingBufferQueue<T, Capacity, Mode>::tryPush(const T &value) {
+        return tryEmplace(value);
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    bool RingBufferQueue<T, Capacity, Mode>::tryPush(T &&value) {
+        return tryEmplace(std::move(value));
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    void RingBufferQueue<T, Capacity, Mode>::push(const T &value) {
+        waitAndEmplace(value, std::stop_token());
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    bool RingBufferQueue<T, Capacity, Mode>::push(const T &value, std::stop_token st) {
+        return waitAndEmplace(value, st);
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    void RingBufferQueue<T, Capacity, Mode>::push(T &&value) {
+        waitAndEmplace(std::move(value), std::stop_token());
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    bool RingBufferQueue<T, Capacity, Mode>::push(T &&value, std::stop_token st) {
+        return waitAndEmplace(std::move(value), st);
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    template <std::input_iterator It, std::sentinel_for<It> S>
+    std::size_t RingBufferQueue<T, Capacity, Mode>::pushRange(It first, S last) {
+        return pushRange(std::move(first), std::move(last), std::stop_token());
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    template <std::input_iterator It, std::sentinel_for<It> S>
+    std::size_t RingBufferQueue<T, Capacity, Mode>::pushRange(
+            It first, S last, std::stop_token st) {
+        std::size_t count = 0;
+        for (; first != last; ++first, ++count)
+            if (!waitAndEmplace(*first, st))
+                break;
+        return count;
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    template <std::ranges::input_range R>
+    std::size_t RingBufferQueue<T, Capacity, Mode>::pushRange(R &&range) {
+        return pushRange(std::ranges::begin(range), std::ranges::end(range));
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    std::size_t RingBufferQueue<T, Capacity, Mode>::pushBulk(std::vector<T> &&values) {
+        return pushBulk(std::move(values), std::stop_token());
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    std::size_t RingBufferQueue<T, Capacity, Mode>::pushBulk(
+            std::vector<T> &&values, std::stop_token st) {
+        std::size_t count = pushRange(
+                std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()),
+                st);
+        values.clear();
+        return count;
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    std::optional<T> RingBufferQueue<T, Capacity, Mode>::extract() {
+        std::optional<T> value;
+        if constexpr (Mode == RingBufferMode::MPMC) {
+            // Claim the slot at the head by advancing the head index. The slot's sequence number
+            // tells us whether a producer has finished writing to it (sequence == pos + 1).
+            std::size_t pos = m_head.load(std::memory_order_relaxed);
+            slot_t *slot;
+            while (true) {
+                slot = &m_slots[pos & mask];
+                std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+                if (diff == 0) {
+                    if (!m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        continue;
+                    if (!slot->tombstone)
+                        break;
+                    // The producer failed to construct the element, free the slot and move on
+                    slot->tombstone = false;
+                    slot->sequence.store(pos + Capacity, std::memory_order_release);
+                    notifyProducers();
+                    pos = m_head.load(std::memory_order_relaxed);
+                } else if (diff < 0)
+                    return std::nullopt;
+                else
+                    pos = m_head.load(std::memory_order_relaxed);
+            }
+            value.emplace(std::move(*slot->get()));
+            slot->get()->~T();
+            // Mark the slot as free for the producer that will arrive on the next lap
+            slot->sequence.store(pos + Capacity, std::memory_order_release);
+        } else {
+            std::size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tailCache) {
+                m_tailCache = m_tail.load(std::memory_order_acquire);
+                if (head == m_tailCache)
+                    return std::nullopt;
+            }
+            slot_t &slot = m_slots[head & mask];
+            value.emplace(std::move(*slot.get()));
+            slot.get()->~T();
+            m_head.store(head + 1, std::memory_order_release);
+        }
+        notifyProducers();
+        return value;
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    std::size_t RingBufferQueue<T, Capacity, Mode>::extractBatch(
+            std::vector<T> &out, std::size_t maxCount) {
+        std::size_t count = 0;
+        for (; count < maxCount; ++count) {
+            std::optional<T> next = extract();
+            if (!next)
+                break;
+            out.push_back(std::move(*next));
+        }
+        return count;
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    std::size_t RingBufferQueue<T, Capacity, Mode>::size() const {
+        std::size_t head = m_head.load(std::memory_order_acquire);
+        std::size_t tail = m_tail.load(std::memory_order_acquire);
+        return tail > head ? std::min(tail - head, Capacity) : 0;
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    bool RingBufferQueue<T, Capacity, Mode>::empty() const {
+        std::size_t head = m_head.load(std::memory_order_acquire);
+        if constexpr (Mode == RingBufferMode::MPMC)
+            // Only count the head as filled once its producer has finished writing it
+            return m_slots[head & mask].sequence.load(std::memory_order_acquire) != head + 1;
+        else
+            return head == m_tail.load(std::memory_order_acquire);
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    bool RingBufferQueue<T, Capacity, Mode>::full() const {
+        std::size_t tail = m_tail.load(std::memory_order_acquire);
+        if constexpr (Mode == RingBufferMode::MPMC) {
+            std::size_t seq = m_slots[tail & mask].sequence.load(std::memory_order_acquire);
+            return static_cast<std::ptrdiff_t>(seq - tail) < 0;
+        } else
+            return tail - m_head.load(std::memory_order_acquire) >= Capacity;
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    bool RingBufferQueue<T, Capacity, Mode>::waitForElement(std::stop_token st) {
+        if (!empty())
+            return true;
+        auto lock = std::unique_lock(m_waitMutex);
+        m_waitingConsumers.fetch_add(1, std::memory_order_relaxed);
+        // Pairs with the fence in notifyConsumers: either the producer sees that we are waiting
+        // or we see its element
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool ready = m_notEmpty.wait(lock, st, [this]() { return !empty(); });
+        m_waitingConsumers.fetch_sub(1, std::memory_order_relaxed);
+        return ready;
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    bool RingBufferQueue<T, Capacity, Mode>::waitForElements(
+            std::stop_token st, std::size_t count,
+            const std::chrono::steady_clock::time_point &deadline) {
+        if (size() >= count)
+            return true;
+        auto lock = std::unique_lock(m_waitMutex);
+        m_waitingConsumers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool ready = m_notEmpty.wait_until(
+                lock, st, deadline, [this, count]() { return size() >= count; });
+        m_waitingConsumers.fetch_sub(1, std::memory_order_relaxed);
+        return ready;
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    template <typename U>
+    bool RingBufferQueue<T, Capacity, Mode>::tryEmplace(U &&value) {
+        if constexpr (Mode == RingBufferMode::MPMC) {
+            // Claim the slot at the tail by advancing the tail index. The slot is free once its
+            // sequence number has been set to pos by the consumer of the previous lap.
+            std::size_t pos = m_tail.load(std::memory_order_relaxed);
+            slot_t *slot;
+            while (true) {
+                slot = &m_slots[pos & mask];
+                std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+                if (diff == 0) {
+                    if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0)
+                    return false;
+                else
+                    pos = m_tail.load(std::memory_order_relaxed);
+            }
+            if constexpr (std::is_nothrow_constructible_v<T, U &&>)
+                ::new (slot->storage) T(std::forward<U>(value));
+            else {
+                try {
+                    ::new (slot->storage) T(std::forward<U>(value));
+                } catch (...) {
+                    // The slot has been claimed so it must still be published, otherwise the
+                    // consumers would wait on it forever
+                    slot->tombstone = true;
+                    slot->sequence.store(pos + 1, std::memory_order_release);
+                    notifyConsumers();
+                    throw;
+                }
+            }
+            slot->sequence.store(pos + 1, std::memory_order_release);
+        } else {
+            std::size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_headCache == Capacity) {
+                m_headCache = m_head.load(std::memory_order_acquire);
+                if (tail - m_headCache == Capacity)
+                    return false;
+            }
+            ::new (m_slots[tail & mask].storage) T(std::forward<U>(value));
+            m_tail.store(tail + 1, std::memory_order_release);
+        }
+        notifyConsumers();
+        return true;
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    template <typename U>
+    bool RingBufferQueue<T, Capacity, Mode>::waitAndEmplace(U &&value, std::stop_token st) {
+        // tryEmplace only consumes the value when it succeeds so it is safe to retry
+        while (!tryEmplace(std::forward<U>(value)))
+            if (!waitForSpace(st))
+                return false;
+        return true;
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    bool RingBufferQueue<T, Capacity, Mode>::waitForSpace(std::stop_token st) {
+        if (!full())
+            return true;
+        auto lock = std::unique_lock(m_waitMutex);
+        m_waitingProducers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool ready = m_notFull.wait(lock, st, [this]() { return !full(); });
+        m_waitingProducers.fetch_sub(1, std::memory_order_relaxed);
+        return ready;
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    void RingBufferQueue<T, Capacity, Mode>::notifyConsumers() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waitingConsumers.load(std::memory_order_relaxed) == 0)
+            return;
+        // Acquiring the mutex ensures that the waiting thread is either already asleep or has not
+        // yet checked its predicate
+        std::vector<std::function<void()>> callbacks;
+        {
+            std::lock_guard lock(m_waitMutex);
+            callbacks.swap(m_readyCallbacks);
+            m_waitingConsumers.fetch_sub(callbacks.size(), std::memory_order_relaxed);
+        }
+        m_notEmpty.notify_one();
+        for (auto &callback : callbacks)
+            callback();
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    void RingBufferQueue<T, Capacity, Mode>::notifyProducers() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waitingProducers.load(std::memory_order_relaxed) == 0)
+            return;
+        { std::lock_guard lock(m_waitMutex); }
+        m_notFull.notify_one();
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    template <typename F, typename... Args>
+        requires Consumer<F, T, Args...>
+    std::future<TaskStatus> RingBufferQueue<T, Capacity, Mode>::loopConsumer(
+            std::stop_source ss, F &&f, Args &&...args) {
+        return std::async(
+                std::launch::async,
+                [this](std::stop_source ss, F &&f, Args &&...args) {
+                    auto st = ss.get_token();
+                    while (!st.stop_requested()) {
+                        while (auto next = this->extract()) {
+                            TaskStatus status{TaskStatus::CONTINUE};
+                            try {
+                                status = std::invoke(f, *next, std::forward<Args>(args)...);
+                            } catch (...) {
+                                ss.request_stop();
+                                throw;
+                            }
+
+                            switch (status) {
+                            case TaskStatus::CONTINUE:
+                                break;
+                            case TaskStatus::HALT:
+                                return TaskStatus::HALT;
+                            case TaskStatus::ABORT:
+                                ss.request_stop();
+                                return TaskStatus::ABORT;
+                            }
+                        }
+                        this->waitForElement(st);
+                    }
+                    return TaskStatus::CONTINUE;
+                },
+                ss, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    template <typename F, typename... Args>
+        requires BatchConsumer<F, T, Args...>
+    std::future<TaskStatus> RingBufferQueue<T, Capacity, Mode>::loopConsumer(
+            std::stop_source ss, const BatchOptions &options, F &&f, Args &&...args) {
+        return std::async(
+                std::launch::async,
+                [this](std::stop_source ss, BatchOptions options, F &&f, Args &&...args) {
+                    return detail::consumeBatches(
+                            *this, ss, options, [&f, &args...](std::span<const T> batch) {
+                                return std::invoke(f, batch, args...);
+                            });
+                },
+                ss, options, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    template <typename F, typename... Args>
+        requires Consumer<F, T, Args...>
+    std::future<TaskStatus> RingBufferQueue<T, Capacity, Mode>::loopConsumer(
+            Executor &executor, std::stop_source ss, F &&f, Args &&...args) {
+        auto consume = [f = std::forward<F>(f),
+                        ... args = std::forward<Args>(args)](std::span<const T> batch) mutable {
+            for (const T &element : batch)
+                if (TaskStatus status = std::invoke(f, element, args...);
+                    status != TaskStatus::CONTINUE)
+                    return status;
+            return TaskStatus::CONTINUE;
+        };
+        return detail::ExecutorConsumer<RingBufferQueue, decltype(consume)>::start(
+                executor, *this, ss, BatchOptions{1}, std::move(consume));
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    template <typename F, typename... Args>
+        requires BatchConsumer<F, T, Args...>
+    std::future<TaskStatus> RingBufferQueue<T, Capacity, Mode>::loopConsumer(
+            Executor &executor, std::stop_source ss, const BatchOptions &options, F &&f,
+            Args &&...args) {
+        auto consume = [f = std::forward<F>(f),
+                        ... args = std::forward<Args>(args)](std::span<const T> batch) mutable {
+            return std::invoke(f, batch, args...);
+        };
+        return detail::ExecutorConsumer<RingBufferQueue, decltype(consume)>::start(
+                executor, *this, ss, options, std::move(consume));
+    }
+
+    template <typename T, std::size_t Capacity, RingBufferMode Mode>
+    void RingBufferQueue<T, Capacity, Mode>::onElementReady(std::function<void()> callback) {
+        {
+            auto lock = std::unique_lock(m_waitMutex);
+            if (empty()) {
+                // Register as a waiting consumer so that producers take the slow path
+                m_readyCallbacks.push_back(std::move(callback));
+                m_waitingConsumers.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (empty())
+                    return;
+                // An element arrived before the producer could see the registration
+                callback = std::move(m_readyCallbacks.back());
+                m_readyCallbacks.pop_back();
+                m_waitingConsumers.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        callback();
+    }
+} // namespace AsyncQueue
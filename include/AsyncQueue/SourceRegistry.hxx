@@ -0,0 +1,121 @@
+/**
+ * @file SourceRegistry.hxx
+ * @brief Process-wide table of interned message source names
+ */
+
+#ifndef ASYNCQUEUE_SOURCEREGISTRY_HXX
+#define ASYNCQUEUE_SOURCEREGISTRY_HXX
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace AsyncQueue {
+    /// @brief Identifier of a source name interned in the SourceRegistry
+    using SourceId = std::uint32_t;
+
+    /// @brief Value used for sources which have not been interned
+    static constexpr inline SourceId invalidSourceId = std::numeric_limits<SourceId>::max();
+
+    /**
+     * @brief Process-wide table of message source names
+     *
+     * Source names are interned once, when the MessageSource is created, after which messages
+     * refer to them by ID and by a view of the stored name. Names are never removed so views
+     * returned by the registry remain valid for the lifetime of the program.
+     *
+     * Source names are expected to come from a small, fixed set, such as one per component or
+     * thread. Names built from per-request data would otherwise grow the registry without limit,
+     * so it holds at most capacity() names. New names beyond that are not interned and each
+     * SourceName created from one owns a copy instead.
+     */
+    class SourceRegistry {
+    public:
+        /// @brief The default maximum number of interned names
+        static constexpr std::size_t defaultCapacity = 4096;
+
+        /// @brief The registry used by all message sources
+        static SourceRegistry &global();
+
+        /// @brief Intern a name, returning the existing ID if it has been seen before
+        /// @return The ID, or invalidSourceId if the name is new and the registry is full
+        SourceId intern(std::string_view name);
+
+        /// @brief Get the interned copy of a name. Returns an empty view for an unknown ID
+        std::string_view name(SourceId id) const;
+
+        /// @brief The number of interned names. IDs are allocated contiguously from 0
+        std::size_t size() const;
+
+        /// @brief The maximum number of interned names
+        std::size_t capacity() const;
+        /// @brief Set the maximum number of interned names. Names already interned are kept
+        void setCapacity(std::size_t capacity);
+
+    private:
+        SourceRegistry() = default;
+
+        mutable std::mutex m_mutex;
+        std::size_t m_capacity{defaultCapacity};
+        /// @brief Storage for the names. A deque never moves its elements when growing
+        std::deque<std::string> m_names;
+        std::unordered_map<std::string_view, SourceId> m_ids;
+    };
+
+    /**
+     * @brief The name of a message source, interned in the global SourceRegistry
+     *
+     * Creating a SourceName from a string interns it, so the name remains valid however long the
+     * message carrying it is kept, whatever happens to the original string. Copying a SourceName
+     * never touches the registry, so sources create one up front and copy it into each message.
+     *
+     * If the registry is full the name is not interned. The SourceName then shares ownership of
+     * a copy of the name with its copies, and its id is invalidSourceId.
+     */
+    class SourceName {
+    public:
+        /// @brief The empty name, which is not interned
+        SourceName() = default;
+        /// @brief Intern a name
+        SourceName(std::string_view name);
+        SourceName(const std::string &name) : SourceName(std::string_view(name)) {}
+        SourceName(const char *name) : SourceName(std::string_view(name)) {}
+        /// @brief Refer to a name which has already been interned
+        explicit SourceName(SourceId id);
+
+        /// @brief The ID of the name in the SourceRegistry
+        ///
+        /// This is invalidSourceId for the default constructed name and for names which were
+        /// created when the registry was full.
+        SourceId id() const { return m_id; }
+        /// @brief View the name
+        std::string_view view() const { return m_name; }
+        /// @brief View the name
+        operator std::string_view() const { return m_name; }
+        /// @brief Copy the name
+        std::string str() const { return std::string(m_name); }
+        std::size_t size() const { return m_name.size(); }
+        bool empty() const { return m_name.empty(); }
+
+        friend bool operator==(const SourceName &lhs, std::string_view rhs) {
+            return lhs.m_name == rhs;
+        }
+        friend std::ostream &operator<<(std::ostream &os, const SourceName &name) {
+            return os << name.m_name;
+        }
+
+    private:
+        SourceId m_id{invalidSourceId};
+        std::string_view m_name;
+        /// @brief The storage for a name which could not be interned
+        std::shared_ptr<const std::string> m_owned;
+    };
+} // namespace AsyncQueue
+
+#endif //> !ASYNCQUEUE_SOURCEREGISTRY_HXX
@@ -1,17 +1,22 @@
 #ifndef ASYNCQUEUE_TEECONSUMER_HXX
 #define ASYNCQUEUE_TEECONSUMER_HXX
 
+#include "AsyncQueue/IBatchConsumer.hxx"
 #include "AsyncQueue/IConsumer.hxx"
 
 #include <concepts>
 #include <memory>
+#include <span>
 #include <type_traits>
 #include <vector>
 
 namespace AsyncQueue {
     /// @brief Consumer that takes an element and forwards it to multiple consumers
     /// @tparam T The elementt type of the queue
-    template <typename T> class TeeConsumer : public IConsumer<T> {
+    ///
+    /// Batches are forwarded whole to any contained batch consumers, other consumers receive the
+    /// elements one at a time.
+    template <typename T> class TeeConsumer : public IBatchConsumer<T> {
     public:
         /// @brief Create an empty consumer
         TeeConsumer() = default;
@@ -33,12 +38,20 @@ namespace AsyncQueue {
         /// @brief Add a new consumer to this that is managed outside this class
         void addConsumer(IConsumer<T> *consumer);
 
-        /// @brief Consume single element
-        TaskStatus consume(const T &element) override;
+        using IBatchConsumer<T>::consume;
+        /// @brief Consume several elements
+        TaskStatus consume(std::span<const T> elements) override;
 
     private:
+        /// @brief A contained consumer
+        struct Entry {
+            IConsumer<T> *consumer;
+            /// @brief The consumer if it accepts batches, resolved once when it is added
+            IBatchConsumer<T> *batchConsumer;
+        };
+
         std::vector<std::unique_ptr<IConsumer<T>>> m_owned;
-        std::vector<IConsumer<T> *> m_consumers;
+        std::vector<Entry> m_consumers;
     };
 } // namespace AsyncQueue
 
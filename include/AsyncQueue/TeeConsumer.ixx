@@ -21,13 +21,20 @@ namespace AsyncQueue {
     }
 
     template <typename T> void TeeConsumer<T>::addConsumer(IConsumer<T> *consumer) {
-        m_consumers.push_back(consumer);
+        m_consumers.push_back({consumer, dynamic_cast<IBatchConsumer<T> *>(consumer)});
     }
 
-    template <typename T> TaskStatus TeeConsumer<T>::consume(const T &element) {
+    template <typename T> TaskStatus TeeConsumer<T>::consume(std::span<const T> elements) {
         auto itr = m_consumers.begin();
         while (itr != m_consumers.end()) {
-            switch ((**itr).consume(element)) {
+            TaskStatus status{TaskStatus::CONTINUE};
+            if (itr->batchConsumer)
+                status = itr->batchConsumer->consume(elements);
+            else
+                for (const T &element : elements)
+                    if ((status = itr->consumer->consume(element)) != TaskStatus::CONTINUE)
+                        break;
+            switch (status) {
             case TaskStatus::CONTINUE:
                 ++itr;
                 break;
@@ -36,7 +43,7 @@ namespace AsyncQueue {
                 auto ownedItr = std::find_if(
                         m_owned.begin(), m_owned.end(),
                         [itr](const std::unique_ptr<IConsumer<T>> &ptr) {
-                            return ptr.get() == *itr;
+                            return ptr.get() == itr->consumer;
                         });
                 if (ownedItr != m_owned.end())
                     m_owned.erase(ownedItr);
@@ -17,6 +17,7 @@
 
 #include <chrono>
 #include <concepts>
+#include <span>
 #include <type_traits>
 
 namespace AsyncQueue {
@@ -40,6 +41,22 @@ namespace AsyncQueue {
         /// @brief Concept only satisfied by std::chrono::time_points
         template <typename T>
         concept TimePoint = SpecialisationOf<T, std::chrono::time_point>;
+        /// @brief Concept satisfied by queues which are protected by an externally visible lock
+        template <typename Q>
+        concept LockableQueue = requires(const Q &q) {
+            typename Q::lock_t;
+            { q.lock() } -> std::same_as<typename Q::lock_t>;
+        };
+        /// @brief Concept satisfied by queues which can take back elements they handed out
+        template <typename Q>
+        concept RequeueableQueue = requires(Q &q, std::span<typename Q::value_type> values) {
+            q.requeue(values);
+        };
+        /// @brief Concept satisfied by types which carry a message level (e.g. Message)
+        template <typename T>
+        concept HasMessageLevel = requires(const T &t) {
+            { t.level } -> std::convertible_to<MessageLevel>;
+        };
     } // namespace concepts
 } // namespace AsyncQueue
 
@@ -0,0 +1,143 @@
+#include "AsyncQueue/BinaryLog.hxx"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace AsyncQueue {
+    namespace {
+        /// @brief Read a value from unaligned memory
+        template <typename T> T load(const char *data) {
+            T value;
+            std::memcpy(&value, data, sizeof(T));
+            return value;
+        }
+    } // namespace
+
+    std::string binaryLogSegmentPath(const std::string &prefix, std::size_t index) {
+        // Pad the index so that the names sort in order
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%06zu", index);
+        return prefix + suffix + std::string(detail::binaryLogExtension);
+    }
+
+    std::vector<std::string> findBinaryLogSegments(const std::string &prefix) {
+        std::filesystem::path base(prefix);
+        std::filesystem::path dir = base.has_parent_path() ? base.parent_path() : ".";
+        std::string stem = base.filename().string() + ".";
+        std::vector<std::pair<std::size_t, std::string>> found;
+        std::error_code ec;
+        for (const auto &entry : std::filesystem::directory_iterator(dir, ec)) {
+            std::string name = entry.path().filename().string();
+            if (!name.starts_with(stem) || !name.ends_with(detail::binaryLogExtension))
+                continue;
+            std::string_view index(name);
+            index.remove_prefix(stem.size());
+            index.remove_suffix(detail::binaryLogExtension.size());
+            if (index.empty() || !std::all_of(index.begin(), index.end(), [](char c) {
+                    return c >= '0' && c <= '9';
+                }))
+                continue;
+            found.emplace_back(std::stoull(std::string(index)), entry.path().string());
+        }
+        std::sort(found.begin(), found.end());
+        std::vector<std::string> paths;
+        paths.reserve(found.size());
+        for (auto &[index, path] : found)
+            paths.push_back(std::move(path));
+        return paths;
+    }
+
+    Message BinaryLogRecord::toMessage() const {
+        return {.source = source, .time = time, .level = level, .message = MessageText(text)};
+    }
+
+    BinaryLogSegment::BinaryLogSegment(const std::string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "Opening " + path);
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "Reading " + path);
+        }
+        m_size = info.st_size;
+        if (m_size > 0) {
+            void *data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            int error = errno;
+            ::close(fd);
+            if (data == MAP_FAILED)
+                throw std::system_error(error, std::generic_category(), "Mapping " + path);
+            m_data = static_cast<const char *>(data);
+        } else
+            ::close(fd);
+        if (m_size < detail::binaryLogHeaderSize ||
+            std::string_view(m_data, detail::binaryLogMagic.size()) != detail::binaryLogMagic ||
+            load<std::uint32_t>(m_data + 8) != detail::binaryLogVersion ||
+            load<std::uint32_t>(m_data + 12) != detail::binaryLogByteOrder) {
+            if (m_data)
+                ::munmap(const_cast<char *>(m_data), m_size);
+            throw std::runtime_error(path + " is not a supported binary log segment");
+        }
+    }
+
+    BinaryLogSegment::~BinaryLogSegment() {
+        if (m_data)
+            ::munmap(const_cast<char *>(m_data), m_size);
+    }
+
+    bool BinaryLogSegment::next(
+            std::size_t &offset, BinaryLogRecord &record, bool &isMessage,
+            std::vector<std::string_view> &sources) const {
+        if (offset >= m_size)
+            return false;
+        const char *data = m_data + offset;
+        std::size_t available = m_size - offset;
+        switch (static_cast<detail::BinaryRecordType>(data[0])) {
+        case detail::BinaryRecordType::Source: {
+            if (available < detail::binaryLogSourceSize)
+                return false;
+            std::uint32_t index = load<std::uint32_t>(data + 4);
+            std::uint32_t length = load<std::uint32_t>(data + 8);
+            if (index != sources.size() || available - detail::binaryLogSourceSize < length)
+                return false;
+            sources.emplace_back(data + detail::binaryLogSourceSize, length);
+            offset += detail::binaryLogSourceSize + length;
+            isMessage = false;
+            return true;
+        }
+        case detail::BinaryRecordType::Message: {
+            if (available < detail::binaryLogMessageSize)
+                return false;
+            auto level = static_cast<std::uint8_t>(data[1]);
+            std::uint32_t source = load<std::uint32_t>(data + 4);
+            std::uint32_t length = load<std::uint32_t>(data + 16);
+            if (level > static_cast<std::uint8_t>(MessageLevel::ABORT) ||
+                source >= sources.size() || available - detail::binaryLogMessageSize < length)
+                return false;
+            record.source = sources[source];
+            record.time = std::chrono::time_point<std::chrono::system_clock>(
+                    std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                            std::chrono::nanoseconds(load<std::int64_t>(data + 8))));
+            record.level = static_cast<MessageLevel>(level);
+            record.text = std::string_view(data + detail::binaryLogMessageSize, length);
+            offset += detail::binaryLogMessageSize + length;
+            isMessage = true;
+            return true;
+        }
+        }
+        // An unknown record type means the rest of the segment cannot be decoded
+        return false;
+    }
+} // namespace AsyncQueue
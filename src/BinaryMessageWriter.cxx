@@ -0,0 +1,141 @@
+#include "AsyncQueue/BinaryMessageWriter.hxx"
+
+#include <cerrno>
+#include <chrono>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace AsyncQueue {
+    namespace {
+        /// @brief Append a value in native byte order
+        template <typename T> void store(std::string &out, T value) {
+            out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        /// @brief Write all of data, retrying after partial writes and interruptions
+        bool writeAll(int fd, std::string_view data) {
+            while (!data.empty()) {
+                ssize_t count = ::write(fd, data.data(), data.size());
+                if (count < 0 && errno == EINTR)
+                    continue;
+                if (count <= 0)
+                    return false;
+                data.remove_prefix(count);
+            }
+            return true;
+        }
+    } // namespace
+
+    BinaryMessageWriter::BinaryMessageWriter(
+            const std::string &prefix, MessageLevel lvl, std::size_t maxSegmentSize)
+            : m_prefix(prefix), m_lvl(lvl), m_maxSegmentSize(maxSegmentSize) {
+        std::vector<std::string> existing = findBinaryLogSegments(prefix);
+        if (!existing.empty()) {
+            // The index is the number between the prefix and the extension
+            std::string last = existing.back();
+            last.resize(last.size() - detail::binaryLogExtension.size());
+            m_index = std::stoull(last.substr(last.rfind('.') + 1)) + 1;
+        }
+        if (!openSegment())
+            throw std::system_error(errno, std::generic_category(), "Creating " + segmentPath());
+    }
+
+    BinaryMessageWriter::~BinaryMessageWriter() {
+        if (m_fd >= 0)
+            ::close(m_fd);
+    }
+
+    TaskStatus BinaryMessageWriter::consume(std::span<const Message> messages) {
+        if ((m_fd < 0 || m_segmentSize >= m_maxSegmentSize) && !openSegment()) {
+            for (const Message &message : messages)
+                m_nDropped += message.level >= m_lvl;
+            return TaskStatus::CONTINUE;
+        }
+        m_buffer.clear();
+        std::size_t count = 0;
+        for (const Message &message : messages) {
+            if (message.level < m_lvl)
+                continue;
+            std::uint32_t source = segmentSource(message);
+            std::string_view text = message.message.view();
+            store(m_buffer, detail::BinaryRecordType::Message);
+            store(m_buffer, static_cast<std::uint8_t>(message.level));
+            store(m_buffer, std::uint16_t{0});
+            store(m_buffer, source);
+            store(m_buffer,
+                  static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                    message.time.time_since_epoch())
+                                                    .count()));
+            store(m_buffer, static_cast<std::uint32_t>(text.size()));
+            m_buffer.append(text);
+            ++count;
+        }
+        if (writeAll(m_fd, m_buffer))
+            m_segmentSize += m_buffer.size();
+        else {
+            // The segment may now end part way through a record so start a new one
+            m_nDropped += count;
+            ::close(m_fd);
+            m_fd = -1;
+        }
+        return TaskStatus::CONTINUE;
+    }
+
+    bool BinaryMessageWriter::openSegment() {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            ++m_index;
+        }
+        std::string path = segmentPath();
+        // Never overwrite an existing segment
+        m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (m_fd < 0) {
+            if (errno == EEXIST)
+                ++m_index;
+            return false;
+        }
+        m_segmentSources.clear();
+        m_segmentUninterned.clear();
+        m_nSegmentSources = 0;
+        std::string header(detail::binaryLogMagic);
+        store(header, detail::binaryLogVersion);
+        store(header, detail::binaryLogByteOrder);
+        if (!writeAll(m_fd, header)) {
+            ::close(m_fd);
+            m_fd = -1;
+            ::unlink(path.c_str());
+            return false;
+        }
+        m_segmentSize = header.size();
+        return true;
+    }
+
+    std::uint32_t BinaryMessageWriter::segmentSource(const Message &message) {
+        SourceId id = message.source.id();
+        if (id == invalidSourceId) {
+            // The name was created while the registry was full, so look it up by value
+            auto [itr, inserted] = m_segmentUninterned.try_emplace(message.source.str(), 0);
+            if (inserted)
+                itr->second = addSegmentSource(message.source.view());
+            return itr->second - 1;
+        }
+        if (id >= m_segmentSources.size())
+            m_segmentSources.resize(id + 1, 0);
+        // First use in this segment, so add it to the dictionary
+        if (m_segmentSources[id] == 0)
+            m_segmentSources[id] = addSegmentSource(message.source.view());
+        return m_segmentSources[id] - 1;
+    }
+
+    std::uint32_t BinaryMessageWriter::addSegmentSource(std::string_view name) {
+        store(m_buffer, detail::BinaryRecordType::Source);
+        store(m_buffer, std::uint8_t{0});
+        store(m_buffer, std::uint16_t{0});
+        store(m_buffer, m_nSegmentSources);
+        store(m_buffer, static_cast<std::uint32_t>(name.size()));
+        m_buffer.append(name);
+        return ++m_nSegmentSources;
+    }
+} // namespace AsyncQueue
@@ -0,0 +1,171 @@
+#include "AsyncQueue/Executor.hxx"
+
+#include <algorithm>
+
+namespace AsyncQueue {
+    namespace {
+        /// @brief The executor owning the current thread, if any
+        thread_local const Executor *currentExecutor = nullptr;
+        /// @brief The index of the current thread in its executor
+        thread_local std::size_t currentWorker = 0;
+    } // namespace
+
+    Executor::Executor(std::size_t nThreads, clock_t::duration tick, std::size_t wheelSize)
+            : m_tick(std::max(tick, clock_t::duration(1))),
+              m_wheel(std::max<std::size_t>(wheelSize, 1)), m_wheelTime(clock_t::now()) {
+        if (nThreads == 0)
+            nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        m_workers.reserve(nThreads);
+        for (std::size_t idx = 0; idx < nThreads; ++idx)
+            m_workers.push_back(std::make_unique<Worker>());
+        m_threads.reserve(nThreads);
+        for (std::size_t idx = 0; idx < nThreads; ++idx)
+            m_threads.emplace_back(&Executor::workerLoop, this, idx);
+        m_timerThread = std::thread(&Executor::timerLoop, this);
+    }
+
+    Executor::~Executor() {
+        m_stopping = true;
+        {
+            std::lock_guard lock(m_idleMutex);
+        }
+        m_idleCv.notify_all();
+        {
+            std::lock_guard lock(m_timerMutex);
+        }
+        m_timerCv.notify_all();
+        for (std::thread &thread : m_threads)
+            thread.join();
+        m_timerThread.join();
+    }
+
+    void Executor::submit(task_t task) {
+        std::size_t index = currentExecutor == this
+                                    ? currentWorker
+                                    : m_nextWorker.fetch_add(1, std::memory_order_relaxed) %
+                                              m_workers.size();
+        {
+            Worker &worker = *m_workers[index];
+            std::lock_guard lock(worker.mutex);
+            worker.tasks.push_back(std::move(task));
+        }
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+        // Pairs with the fence in workerLoop: either the sleeping thread sees the new task or
+        // this thread sees that it is asleep
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_idle.load(std::memory_order_relaxed) > 0) {
+            {
+                std::lock_guard lock(m_idleMutex);
+            }
+            m_idleCv.notify_one();
+        }
+    }
+
+    void Executor::schedule(clock_t::time_point deadline, task_t task) {
+        bool due = true;
+        bool earliest = false;
+        {
+            std::lock_guard lock(m_timerMutex);
+            auto now = clock_t::now();
+            if (deadline > now) {
+                due = false;
+                // While the wheel is empty the timer thread doesn't advance it, so bring it up to
+                // date rather than making the timer thread catch up
+                if (m_timerCount == 0)
+                    m_wheelTime = now;
+                auto ticks = (deadline - m_wheelTime + m_tick - clock_t::duration(1)) / m_tick;
+                std::size_t slot = (m_cursor + static_cast<std::size_t>(ticks)) % m_wheel.size();
+                m_wheel[slot].push_back(Timer{deadline, std::move(task)});
+                ++m_timerCount;
+                earliest = m_deadlines.empty() || deadline < m_deadlines.top();
+                m_deadlines.push(deadline);
+            }
+        }
+        if (due)
+            submit(std::move(task));
+        else if (earliest)
+            // The timer thread is sleeping until a later deadline
+            m_timerCv.notify_one();
+    }
+
+    void Executor::workerLoop(std::size_t index) {
+        currentExecutor = this;
+        currentWorker = index;
+        while (!m_stopping) {
+            if (runNext(index))
+                continue;
+            std::unique_lock lock(m_idleMutex);
+            m_idle.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_idleCv.wait(lock, [this]() {
+                return m_pending.load(std::memory_order_relaxed) > 0 || m_stopping;
+            });
+            m_idle.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    bool Executor::runNext(std::size_t index) {
+        task_t task;
+        {
+            Worker &worker = *m_workers[index];
+            std::lock_guard lock(worker.mutex);
+            if (!worker.tasks.empty()) {
+                task = std::move(worker.tasks.front());
+                worker.tasks.pop_front();
+            }
+        }
+        // Steal from the opposite end to the owner to reduce contention
+        for (std::size_t offset = 1; !task && offset < m_workers.size(); ++offset) {
+            Worker &victim = *m_workers[(index + offset) % m_workers.size()];
+            std::lock_guard lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.back());
+                victim.tasks.pop_back();
+            }
+        }
+        if (!task)
+            return false;
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+        task();
+        return true;
+    }
+
+    void Executor::timerLoop() {
+        std::unique_lock lock(m_timerMutex);
+        while (!m_stopping) {
+            if (m_timerCount == 0) {
+                m_timerCv.wait(lock, [this]() { return m_timerCount > 0 || m_stopping; });
+                continue;
+            }
+            // Sleep until the tick on which the earliest timer is due. An earlier timer or the
+            // destructor wakes this early, after which the wait is recalculated
+            auto ticks = std::max<clock_t::rep>(
+                    (m_deadlines.top() - m_wheelTime + m_tick - clock_t::duration(1)) / m_tick, 1);
+            m_timerCv.wait_until(lock, m_wheelTime + ticks * m_tick);
+            std::vector<task_t> due;
+            auto now = clock_t::now();
+            while (m_timerCount > 0 && m_wheelTime + m_tick <= now) {
+                m_wheelTime += m_tick;
+                m_cursor = (m_cursor + 1) % m_wheel.size();
+                // Timers further away than one turn of the wheel share the slot, leave them
+                std::vector<Timer> &slot = m_wheel[m_cursor];
+                auto remaining = std::partition(slot.begin(), slot.end(), [this](const Timer &t) {
+                    return t.deadline > m_wheelTime;
+                });
+                for (auto itr = remaining; itr != slot.end(); ++itr)
+                    due.push_back(std::move(itr->task));
+                m_timerCount -= slot.end() - remaining;
+                slot.erase(remaining, slot.end());
+            }
+            // Exactly the timers due by m_wheelTime have been removed from the wheel
+            while (!m_deadlines.empty() && m_deadlines.top() <= m_wheelTime)
+                m_deadlines.pop();
+            if (due.empty())
+                continue;
+            lock.unlock();
+            for (task_t &task : due)
+                submit(std::move(task));
+            lock.lock();
+        }
+    }
+} // namespace AsyncQueue
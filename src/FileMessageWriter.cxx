@@ -1,13 +1,470 @@
 #include "AsyncQueue/FileMessageWriter.hxx"
-#include "AsyncQueue/MessageFormatter.hxx"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef AsyncQueue_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef AsyncQueue_MULTITHREAD
+#include "AsyncQueue/Executor.hxx"
+
+#include <condition_variable>
+#include <deque>
+#endif
 
 namespace AsyncQueue {
+    namespace {
+#ifdef AsyncQueue_MULTITHREAD
+        /// @brief The executor used by writers which aren't given one
+        Executor &defaultExecutor() {
+            static Executor executor(1);
+            return executor;
+        }
+#endif
+
+        /// @brief The form of the UTC time added to rotated files, see rotatedName
+        constexpr const char *stampFormat = "%Y%m%dT%H%M%SZ";
+        /// @brief stampFormat with each digit replaced by '#'
+        constexpr std::string_view stampPattern = "########T######Z";
+
+        /// @brief The name to move the file to when rotating it
+        std::string rotatedName(const std::string &filename) {
+            std::time_t now =
+                    std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+            std::tm tm;
+            gmtime_r(&now, &tm);
+            char stamp[32];
+            std::strftime(stamp, sizeof(stamp), stampFormat, &tm);
+            std::string name = filename + "." + stamp;
+            // Add a counter if the file has already been rotated this second
+            std::string candidate = name;
+            std::error_code ec;
+            for (std::size_t idx = 1; std::filesystem::exists(candidate, ec) ||
+                                      std::filesystem::exists(candidate + ".gz", ec);
+                 ++idx)
+                candidate = name + "-" + std::to_string(idx);
+            return candidate;
+        }
+
+        /// @brief Whether name is the file name of a file moved aside by rotatedName
+        /// @param name The name to check
+        /// @param base The file name, without the directory, of the file being rotated
+        ///
+        /// This is "<base>.<UTC time>", followed by "-<counter>" if more than one file was rotated
+        /// in the same second and ".gz" if it has been compressed.
+        bool isRotatedName(std::string_view name, std::string_view base) {
+            auto isDigit = [](char c) { return std::isdigit(static_cast<unsigned char>(c)); };
+            if (name.size() < base.size() + 1 + stampPattern.size() || !name.starts_with(base) ||
+                name[base.size()] != '.')
+                return false;
+            name.remove_prefix(base.size() + 1);
+            for (std::size_t idx = 0; idx < stampPattern.size(); ++idx)
+                if (stampPattern[idx] == '#' ? !isDigit(name[idx]) : name[idx] != stampPattern[idx])
+                    return false;
+            name.remove_prefix(stampPattern.size());
+            if (name.ends_with(".gz"))
+                name.remove_suffix(3);
+            if (name.empty())
+                return true;
+            return name.size() > 1 && name.front() == '-' &&
+                   std::all_of(name.begin() + 1, name.end(), isDigit);
+        }
+    } // namespace
+
+    class FileMessageWriter::Archiver
+#ifdef AsyncQueue_MULTITHREAD
+            : public std::enable_shared_from_this<Archiver>
+#endif
+    {
+    public:
+#ifdef AsyncQueue_MULTITHREAD
+        Archiver(Executor &executor, const std::string &filename, const FileWriterOptions &options)
+                : m_executor(executor), m_filename(filename), m_compress(options.compress),
+                  m_maxFiles(options.maxRotatedFiles) {}
+#else
+        Archiver(const std::string &filename, const FileWriterOptions &options)
+                : m_filename(filename), m_compress(options.compress),
+                  m_maxFiles(options.maxRotatedFiles) {}
+#endif
+
+        /// @brief Archive a rotated file
+        ///
+        /// In multithreaded builds files are queued and archived in order by a task on the
+        /// executor, which runs while there are files waiting.
+        void push(std::string path) {
+#ifdef AsyncQueue_MULTITHREAD
+            {
+                std::lock_guard lock(m_mutex);
+                m_paths.push_back(std::move(path));
+                if (std::exchange(m_running, true))
+                    return;
+            }
+            m_executor.submit([self = shared_from_this()]() { self->run(); });
+#else
+            archive(path);
+#endif
+        }
+
+#ifdef AsyncQueue_MULTITHREAD
+        /// @brief Wait until every queued file has been archived
+        void wait() {
+            std::unique_lock lock(m_mutex);
+            m_idle.wait(lock, [this]() { return !m_running; });
+        }
+#endif
+
+    private:
+#ifdef AsyncQueue_MULTITHREAD
+        void run() {
+            std::unique_lock lock(m_mutex);
+            while (!m_paths.empty()) {
+                std::string path = std::move(m_paths.front());
+                m_paths.pop_front();
+                lock.unlock();
+                archive(path);
+                lock.lock();
+            }
+            m_running = false;
+            m_idle.notify_all();
+        }
+#endif
+
+        void archive(const std::string &path) {
+            if (m_compress)
+                compress(path);
+            if (m_maxFiles > 0)
+                prune();
+        }
+
+        /// @brief Replace the file with a gzip compressed copy, does nothing without zlib
+        static void compress([[maybe_unused]] const std::string &path) {
+#ifdef AsyncQueue_HAVE_ZLIB
+            int in = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (in < 0)
+                return;
+            std::string target = path + ".gz";
+            gzFile out = gzopen(target.c_str(), "wb");
+            bool ok = out != nullptr;
+            std::vector<char> buffer(1 << 16);
+            while (ok) {
+                ssize_t count = ::read(in, buffer.data(), buffer.size());
+                if (count < 0 && errno == EINTR)
+                    continue;
+                if (count <= 0) {
+                    ok = count == 0;
+                    break;
+                }
+                ok = gzwrite(out, buffer.data(), count) == count;
+            }
+            ::close(in);
+            if (out && gzclose(out) != Z_OK)
+                ok = false;
+            // Keep the uncompressed file if anything went wrong, e.g. the disk is full
+            std::error_code ec;
+            std::filesystem::remove(ok ? path : target, ec);
+#endif
+        }
+
+        void prune() {
+            std::filesystem::path base(m_filename);
+            std::filesystem::path dir = base.has_parent_path() ? base.parent_path() : ".";
+            std::string baseName = base.filename().string();
+            std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>>
+                    rotated;
+            std::error_code ec;
+            for (const auto &entry : std::filesystem::directory_iterator(dir, ec))
+                if (isRotatedName(entry.path().filename().string(), baseName))
+                    rotated.emplace_back(entry.last_write_time(ec), entry.path());
+            if (rotated.size() <= m_maxFiles)
+                return;
+            // Files are rotated and compressed in order so the oldest were written first
+            std::sort(rotated.begin(), rotated.end());
+            for (std::size_t idx = 0; idx < rotated.size() - m_maxFiles; ++idx)
+                std::filesystem::remove(rotated[idx].second, ec);
+        }
+
+#ifdef AsyncQueue_MULTITHREAD
+        Executor &m_executor;
+        std::mutex m_mutex;
+        std::condition_variable m_idle;
+        /// @brief Rotated files waiting to be archived
+        std::deque<std::string> m_paths;
+        /// @brief Whether a task archiving m_paths has been submitted
+        bool m_running{false};
+#endif
+        const std::string m_filename;
+        const bool m_compress;
+        const std::size_t m_maxFiles;
+    };
+
+#ifdef AsyncQueue_MULTITHREAD
+    struct FileMessageWriter::FlushTimer {
+        std::mutex mutex;
+        /// @brief Cleared by the writer's destructor, after which the task does nothing
+        FileMessageWriter *writer;
+    };
+#endif
+
     FileMessageWriter::FileMessageWriter(
             const std::string &filename, MessageLevel lvl, std::ios_base::openmode mode)
-            : FileMessageWriter(filename, MessageFormatter(), lvl, mode) {}
+            : FileMessageWriter(filename, FileWriterOptions(), MessageFormatter(), lvl, mode) {}
 
     FileMessageWriter::FileMessageWriter(
             const std::string &filename, formatter_t formatter, MessageLevel lvl,
             std::ios_base::openmode mode)
-            : MessageWriter(m_ofs, lvl), m_ofs(filename, mode) {}
-} // namespace AsyncQueue
\ No newline at end of file
+            : FileMessageWriter(filename, FileWriterOptions(), std::move(formatter), lvl, mode) {}
+
+    FileMessageWriter::FileMessageWriter(
+            const std::string &filename, MessageFormatter formatter, MessageLevel lvl,
+            std::ios_base::openmode mode)
+            : FileMessageWriter(filename, FileWriterOptions(), std::move(formatter), lvl, mode) {}
+
+    FileMessageWriter::FileMessageWriter(
+            const std::string &filename, const FileWriterOptions &options,
+            MessageFormatter formatter, MessageLevel lvl, std::ios_base::openmode mode)
+            : FileMessageWriter(filename, options, formatter_t(), std::move(formatter), lvl, mode) {
+    }
+
+    FileMessageWriter::FileMessageWriter(
+            const std::string &filename, const FileWriterOptions &options,
+            formatter_t formatter, MessageLevel lvl, std::ios_base::openmode mode)
+            : FileMessageWriter(filename, options, std::move(formatter), std::nullopt, lvl, mode) {}
+
+    FileMessageWriter::FileMessageWriter(
+            const std::string &filename, const FileWriterOptions &options, formatter_t format,
+            std::optional<MessageFormatter> formatter, MessageLevel lvl,
+            std::ios_base::openmode mode)
+            :
+#ifdef AsyncQueue_MULTITHREAD
+              m_executor(options.executor ? *options.executor : defaultExecutor()),
+#endif
+              m_options(options), m_filename(filename), m_lvl(lvl), m_format(std::move(format)),
+              m_formatter(std::move(formatter)) {
+        if (!open(mode & std::ios_base::app))
+            throw std::system_error(m_lastError, std::generic_category(), "Opening " + filename);
+        m_buffer.reserve(m_options.bufferSize);
+        m_lastFlush = std::chrono::steady_clock::now();
+        m_rotateAt = std::chrono::system_clock::now() + m_options.rotateInterval;
+#ifdef AsyncQueue_MULTITHREAD
+        if (m_options.maxFileSize > 0 || m_options.rotateInterval.count() > 0)
+            m_archiver = std::make_shared<Archiver>(m_executor, filename, m_options);
+        if (m_options.flushInterval.count() > 0) {
+            m_flushTimer = std::make_shared<FlushTimer>();
+            m_flushTimer->writer = this;
+            std::lock_guard lock(m_mutex);
+            scheduleFlush();
+        }
+#else
+        if (m_options.maxFileSize > 0 || m_options.rotateInterval.count() > 0)
+            m_archiver = std::make_shared<Archiver>(filename, m_options);
+#endif
+    }
+
+    FileMessageWriter::~FileMessageWriter() {
+#ifdef AsyncQueue_MULTITHREAD
+        if (m_flushTimer) {
+            // Waits for a running flush task, later ones do nothing
+            std::lock_guard lock(m_flushTimer->mutex);
+            m_flushTimer->writer = nullptr;
+        }
+#endif
+        {
+            std::lock_guard lock(m_mutex);
+            flushUnlocked();
+            if (m_fd >= 0)
+                ::close(m_fd);
+        }
+#ifdef AsyncQueue_MULTITHREAD
+        if (m_archiver)
+            m_archiver->wait();
+#endif
+    }
+
+    TaskStatus FileMessageWriter::consume(std::span<const Message> messages) {
+        std::lock_guard lock(m_mutex);
+        m_batch.clear();
+        std::size_t count = 0;
+        bool urgent = false;
+        for (const Message &message : messages) {
+            if (message.level < m_lvl)
+                continue;
+            if (m_formatter)
+                m_formatter->format(message, m_batch);
+            else
+                m_batch += m_format(message);
+            ++count;
+            urgent |= message.level >= m_options.flushLevel;
+        }
+        rotateIfDue(m_batch.size());
+        if (m_buffer.size() + m_batch.size() > m_options.bufferSize) {
+            // Any report of discarded messages must be written before the text that followed them
+            if (m_nUnreported > 0 && !flushUnlocked()) {
+                m_buffer += m_batch;
+                m_nBuffered += count;
+            }
+            // Write both in one call rather than copying the batch into the full buffer
+            else if (write(m_batch))
+                m_nBuffered = 0;
+            else
+                m_nBuffered += count;
+            m_lastFlush = std::chrono::steady_clock::now();
+        } else {
+            m_buffer += m_batch;
+            m_nBuffered += count;
+        }
+        // Text only remains beyond the buffer size if the file could not be written
+        if (m_buffer.size() > m_options.bufferSize)
+            discard();
+        if (urgent || std::chrono::steady_clock::now() >= m_lastFlush + m_options.flushInterval)
+            flushUnlocked();
+        return TaskStatus::CONTINUE;
+    }
+
+    bool FileMessageWriter::flush() {
+        std::lock_guard lock(m_mutex);
+        return flushUnlocked();
+    }
+
+    std::size_t FileMessageWriter::droppedMessages() const {
+        std::lock_guard lock(m_mutex);
+        return m_nDropped;
+    }
+
+    bool FileMessageWriter::open(bool append) {
+        int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC);
+        m_fd = ::open(m_filename.c_str(), flags, 0644);
+        if (m_fd < 0) {
+            m_lastError = errno;
+            return false;
+        }
+        struct stat info;
+        m_fileSize = append && ::fstat(m_fd, &info) == 0 ? info.st_size : 0;
+        m_lineOpen = false;
+        return true;
+    }
+
+    bool FileMessageWriter::write(std::string_view extra) {
+        std::size_t nBuffer = 0;
+        std::size_t nExtra = 0;
+        if (m_fd >= 0 || open(true)) {
+            while (nBuffer < m_buffer.size() || nExtra < extra.size()) {
+                iovec iov[2] = {
+                        {m_buffer.data() + nBuffer, m_buffer.size() - nBuffer},
+                        {const_cast<char *>(extra.data()) + nExtra, extra.size() - nExtra}};
+                ssize_t count = ::writev(m_fd, iov, 2);
+                if (count < 0 && errno == EINTR)
+                    continue;
+                if (count <= 0) {
+                    m_lastError = count < 0 ? errno : EIO;
+                    break;
+                }
+                std::size_t fromBuffer =
+                        std::min<std::size_t>(count, m_buffer.size() - nBuffer);
+                nBuffer += fromBuffer;
+                nExtra += count - fromBuffer;
+                m_fileSize += count;
+                m_lineOpen = (nExtra > 0 ? extra[nExtra - 1] : m_buffer[nBuffer - 1]) != '\n';
+            }
+        }
+        m_buffer.erase(0, nBuffer);
+        m_buffer.append(extra.substr(nExtra));
+        return m_buffer.empty();
+    }
+
+    bool FileMessageWriter::flushUnlocked() {
+        m_lastFlush = std::chrono::steady_clock::now();
+        if (m_nUnreported > 0) {
+            // Report the discarded messages before the text that followed them, starting a new
+            // line if the discarded text left one unfinished
+            std::string notice = std::string(m_lineOpen ? "\n" : "") + "FileMessageWriter: " +
+                                 std::to_string(m_nUnreported) +
+                                 " messages were discarded because " + m_filename +
+                                 " could not be written: " + std::strerror(m_lastError) + "\n";
+            std::size_t initialSize = m_fileSize;
+            std::string pending = std::exchange(m_buffer, std::move(notice));
+            bool ok = write(pending);
+            if (m_fileSize == initialSize) {
+                // Nothing was written, try again at the next flush
+                m_buffer = std::move(pending);
+                return false;
+            }
+            m_nUnreported = 0;
+            if (ok)
+                m_nBuffered = 0;
+            return ok;
+        }
+        if (m_buffer.empty())
+            return true;
+        if (!write())
+            return false;
+        m_nBuffered = 0;
+        return true;
+    }
+
+    void FileMessageWriter::rotateIfDue(std::size_t size) {
+        std::size_t current = m_fileSize + m_buffer.size();
+        if ((m_options.maxFileSize > 0 && current > 0 &&
+             current + size > m_options.maxFileSize) ||
+            (m_options.rotateInterval.count() > 0 &&
+             std::chrono::system_clock::now() >= m_rotateAt))
+            rotate();
+    }
+
+    void FileMessageWriter::rotate() {
+        // Everything already buffered belongs in the current file
+        flushUnlocked();
+        m_rotateAt = std::chrono::system_clock::now() + m_options.rotateInterval;
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+        std::string target = rotatedName(m_filename);
+        bool renamed = std::rename(m_filename.c_str(), target.c_str()) == 0;
+        // If the file could not be moved aside keep appending to it. If it cannot be opened at
+        // all the next write tries again
+        open(!renamed);
+        if (renamed)
+            m_archiver->push(target);
+    }
+
+    void FileMessageWriter::discard() {
+        m_nDropped += m_nBuffered;
+        m_nUnreported += m_nBuffered;
+        m_nBuffered = 0;
+        m_buffer.clear();
+    }
+
+#ifdef AsyncQueue_MULTITHREAD
+    void FileMessageWriter::scheduleFlush() {
+        m_executor.schedule(m_lastFlush + m_options.flushInterval, [timer = m_flushTimer]() {
+            std::lock_guard lock(timer->mutex);
+            if (timer->writer)
+                timer->writer->onFlushTimer();
+        });
+    }
+
+    void FileMessageWriter::onFlushTimer() {
+        std::lock_guard lock(m_mutex);
+        // A flush since this was scheduled moves the deadline on
+        if (std::chrono::steady_clock::now() >= m_lastFlush + m_options.flushInterval)
+            flushUnlocked();
+        rotateIfDue(0);
+        scheduleFlush();
+    }
+#endif
+} // namespace AsyncQueue
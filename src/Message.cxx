@@ -1,9 +1,112 @@
 #include "AsyncQueue/Message.hxx"
 
 #include <algorithm>
+#include <array>
+#include <functional>
+#include <mutex>
 #include <stdexcept>
+#include <vector>
 
 namespace AsyncQueue {
+    namespace {
+        /// @brief Pool of string buffers shared by all MessageText objects
+        struct TextPool {
+            /// @brief The maximum number of strings held by the pool
+            static constexpr std::size_t maxSize = 1024;
+            /// @brief Larger buffers are freed rather than kept around
+            static constexpr std::size_t maxCapacity = 4096;
+
+            std::mutex mutex;
+            std::vector<std::string> strings;
+
+            static TextPool &instance() {
+                // Leaked so that messages destroyed during static destruction can still use it
+                static TextPool *pool = [] {
+                    auto pool = new TextPool();
+                    pool->strings.reserve(maxSize);
+                    return pool;
+                }();
+                return *pool;
+            }
+        };
+
+        /// @brief Mutex guarding the rendering of deferred text
+        ///
+        /// Texts are spread over a few mutexes so that consumers rendering different messages
+        /// rarely wait for each other.
+        std::mutex &renderMutex(const MessageText *text) {
+            static std::array<std::mutex, 16> mutexes;
+            return mutexes[std::hash<const MessageText *>()(text) / alignof(MessageText) %
+                           mutexes.size()];
+        }
+    } // namespace
+
+    MessageText::MessageText(std::string_view text) : m_text(acquire()) { m_text.assign(text); }
+
+    MessageText::MessageText(MessageText &&other) noexcept
+            : m_text(std::move(other.m_text)), m_deferred(std::move(other.m_deferred)),
+              m_pending(other.m_pending.exchange(false, std::memory_order_relaxed)) {}
+
+    MessageText &MessageText::operator=(const MessageText &other) {
+        if (this != &other) {
+            const std::string &text = other.str();
+            m_deferred.reset();
+            m_pending.store(false, std::memory_order_relaxed);
+            m_text.assign(text);
+        }
+        return *this;
+    }
+
+    MessageText &MessageText::operator=(MessageText &&other) noexcept {
+        if (this != &other) {
+            recycle(std::move(m_text));
+            m_text = std::move(other.m_text);
+            m_deferred = std::move(other.m_deferred);
+            m_pending.store(
+                    other.m_pending.exchange(false, std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+            other.m_text.clear();
+        }
+        return *this;
+    }
+
+    void MessageText::render() const {
+        std::lock_guard lock(renderMutex(this));
+        if (!m_pending.load(std::memory_order_relaxed))
+            return;
+        if (m_text.capacity() <= std::string().capacity())
+            m_text = acquire();
+        m_deferred->render(m_text);
+        m_deferred.reset();
+        m_pending.store(false, std::memory_order_release);
+    }
+
+    MessageText::~MessageText() { recycle(std::move(m_text)); }
+
+    std::string MessageText::acquire() {
+        TextPool &pool = TextPool::instance();
+        std::lock_guard lock(pool.mutex);
+        if (pool.strings.empty())
+            return std::string();
+        std::string text = std::move(pool.strings.back());
+        pool.strings.pop_back();
+        return text;
+    }
+
+    void MessageText::recycle(std::string &&text) {
+        // Short strings don't own any storage so there is nothing to recycle
+        if (text.capacity() <= std::string().capacity() || text.capacity() > TextPool::maxCapacity)
+            return;
+        text.clear();
+        TextPool &pool = TextPool::instance();
+        std::lock_guard lock(pool.mutex);
+        if (pool.strings.size() < TextPool::maxSize)
+            pool.strings.push_back(std::move(text));
+    }
+
+    std::ostream &operator<<(std::ostream &os, const MessageText &text) {
+        return os << text.view();
+    }
 
     std::string toString(MessageLevel lvl) {
         switch (lvl) {
@@ -1,6 +1,64 @@
 #include "AsyncQueue/MessageFormatter.hxx"
 
+#include <array>
+#include <charconv>
+
 namespace AsyncQueue {
+    namespace {
+        /// @brief The names of each level, so formatting a level does not build a string
+        std::string_view levelName(MessageLevel lvl) {
+            static const std::array<std::string, 6> names{
+                    toString(MessageLevel::VERBOSE), toString(MessageLevel::DEBUG),
+                    toString(MessageLevel::INFO),    toString(MessageLevel::WARNING),
+                    toString(MessageLevel::ERROR),   toString(MessageLevel::ABORT)};
+            return names.at(static_cast<std::size_t>(lvl));
+        }
+    } // namespace
+
+    MessageFormatter::TimeFormat::TimeFormat(const std::string &format) {
+        std::size_t start = 0;
+        std::size_t pos = format.find("%+");
+        while (pos != std::string::npos) {
+            if (pos + 2 >= format.size())
+                break;
+            char code = format.at(pos + 2);
+            if (code != 'n' && code != 'u' && code != 'm')
+                break;
+            m_pieces.push_back(format.substr(start, pos - start));
+            m_codes.push_back(code);
+            start = pos + 3;
+            pos = format.find("%+", start);
+        }
+        m_pieces.push_back(format.substr(start));
+        m_cached.resize(m_pieces.size());
+    }
+
+    void MessageFormatter::TimeFormat::append(
+            std::string &out, std::time_t seconds, std::chrono::nanoseconds subSeconds) const {
+        if (!m_cacheValid || seconds != m_cachedSeconds) {
+            std::tm *tm = std::localtime(&seconds);
+            std::ostringstream oss;
+            for (std::size_t idx = 0; idx < m_pieces.size(); ++idx) {
+                oss.str("");
+                oss << std::put_time(tm, m_pieces[idx].c_str());
+                m_cached[idx] = oss.str();
+            }
+            m_cachedSeconds = seconds;
+            m_cacheValid = true;
+        }
+        for (std::size_t idx = 0; idx < m_cached.size(); ++idx) {
+            out.append(m_cached[idx]);
+            if (idx == m_codes.size())
+                break;
+            std::chrono::nanoseconds::rep count = subSeconds.count();
+            if (m_codes[idx] == 'u')
+                count = std::chrono::duration_cast<std::chrono::microseconds>(subSeconds).count();
+            else if (m_codes[idx] == 'm')
+                count = std::chrono::duration_cast<std::chrono::milliseconds>(subSeconds).count();
+            char digits[24];
+            out.append(digits, std::to_chars(std::begin(digits), std::end(digits), count).ptr);
+        }
+    }
 
     MessageFormatter::MessageFormatter()
             : MessageFormatter(std::vector<Field>{
@@ -11,61 +69,108 @@ namespace AsyncQueue {
 
     MessageFormatter::MessageFormatter(
             const std::vector<Field> &fields, const std::string &sep, bool repeatInfo)
-            : m_fields(fields), m_sep(sep), m_repeatInfo(repeatInfo) {}
+            : m_sep(sep), m_repeatInfo(repeatInfo) {
+        m_plan.reserve(fields.size());
+        for (const Field &field : fields) {
+            m_plan.push_back(compile(field));
+            if (field.type == FieldType::Message)
+                ++m_nMessageFields;
+        }
+    }
 
-    std::string MessageFormatter::formatField(const Message &message, const Field &field) {
-        std::string value = "";
-        switch (field.type) {
+    MessageFormatter::Step MessageFormatter::compile(const Field &field) {
+        Step step{field.type, field.minLength, "", {}};
+        if (field.type == FieldType::Literal) {
+            step.literal = field.extra;
+            if (field.minLength > step.literal.size())
+                step.literal.append(field.minLength - step.literal.size(), ' ');
+        } else if (field.type == FieldType::Time)
+            step.time = TimeFormat(field.extra);
+        return step;
+    }
+
+    void MessageFormatter::appendField(const Message &message, const Step &step, std::string &out) {
+        std::size_t start = out.size();
+        switch (step.type) {
         case FieldType::Name:
-            value = message.source;
+            out.append(message.source.view());
             break;
         case FieldType::Level:
-            value = toString(message.level);
+            out.append(levelName(message.level));
             break;
-        case FieldType::Time:
-            value = formatTime(message.time, field.extra);
+        case FieldType::Time: {
+            auto seconds = std::chrono::floor<std::chrono::seconds>(message.time);
+            step.time.append(
+                    out, std::chrono::system_clock::to_time_t(seconds),
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(message.time - seconds));
             break;
+        }
         case FieldType::Message:
-            value = message.message;
+            out.append(message.message.view());
             break;
         case FieldType::Literal:
-            value = field.extra;
-            break;
+            // Already padded
+            out.append(step.literal);
+            return;
         }
-        if (field.minLength > value.size())
-            value.append(field.minLength - value.size(), ' ');
+        if (step.minLength > out.size() - start)
+            out.append(step.minLength - (out.size() - start), ' ');
+    }
+
+    std::string MessageFormatter::formatField(const Message &message, const Field &field) {
+        std::string value;
+        appendField(message, compile(field), value);
         return value;
     }
 
     std::string MessageFormatter::format(const Message &message) const {
-        std::string value = "";
-        if (m_fields.size() == 0)
-            return value;
-        std::string prefix;
-        std::string suffix;
+        std::string value;
+        format(message, value);
+        return value;
+    }
+
+    void MessageFormatter::format(const Message &message, std::string &out) const {
+        if (m_plan.empty())
+            return;
+        // Render everything except the message text once. The text between each pair of message
+        // fields is the same for every line of the message
+        m_segments.clear();
+        m_segmentEnds.clear();
         bool seenMsg = false;
-        // TODO: This doesn't allow for multiple copies of message
-        for (const Field &field : m_fields) {
-            if (!seenMsg) {
-                if (!prefix.empty())
-                    prefix += m_sep;
-                if (field.type == FieldType::Message)
-                    seenMsg = true;
-                else
-                    prefix += formatField(message, field);
+        for (const Step &step : m_plan) {
+            // Before the first message field separators are only added after non-empty text
+            if (seenMsg || !m_segments.empty())
+                m_segments += m_sep;
+            if (step.type == FieldType::Message) {
+                seenMsg = true;
+                m_segmentEnds.push_back(m_segments.size());
             } else
-                suffix += m_sep + formatField(message, field);
+                appendField(message, step, m_segments);
+        }
+        m_segmentEnds.push_back(m_segments.size());
+        if (m_nMessageFields == 0) {
+            out.append(m_segments);
+            out.push_back('\n');
+            return;
         }
+        std::string_view text = message.message.view();
         std::size_t pos = 0;
         while (true) {
-            std::size_t next = message.message.find('\n', pos);
-            value += prefix + message.message.substr(pos, next - pos) + suffix + '\n';
-            if (next >= message.message.size() - 1)
+            std::size_t next = text.find('\n', pos);
+            std::string_view line = text.substr(pos, next - pos);
+            std::size_t begin = 0;
+            for (std::size_t idx = 0; idx < m_segmentEnds.size(); ++idx) {
+                if (idx > 0)
+                    out.append(line);
+                out.append(m_segments, begin, m_segmentEnds[idx] - begin);
+                begin = m_segmentEnds[idx];
+            }
+            out.push_back('\n');
+            if (next >= text.size() - 1)
                 break;
             else
                 pos = next + 1;
         }
-        return value;
     }
 
 } // namespace AsyncQueue
\ No newline at end of file
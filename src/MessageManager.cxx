@@ -25,6 +25,10 @@ namespace AsyncQueue {
     }
 
     MessageSource MessageManager::createSource(const std::string &name, MessageLevel lvl) {
+#ifdef AsyncQueue_MULTITHREAD
+        return MessageSource(name, m_queue.queue(), lvl, m_queue.closedToken());
+#else
         return MessageSource(name, m_queue.queue(), lvl);
+#endif
     }
 } // namespace AsyncQueue
\ No newline at end of file
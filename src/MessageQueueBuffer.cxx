@@ -1,29 +1,77 @@
 #include "AsyncQueue/MessageQueueBuffer.hxx"
 #include "AsyncQueue/AsyncQueue.hxx"
 
+#include <algorithm>
+
 namespace AsyncQueue {
-    MessageQueueBuffer::MessageQueueBuffer() : std::stringbuf(std::ios::out) {}
+    MessageQueueBuffer::MessageQueueBuffer() {}
+
+    MessageQueueBuffer::MessageQueueBuffer(
+            MessageQueue &queue, MessageLevel lvl, SourceName source)
+            : m_queue(&queue), m_lvl(lvl), m_source(source) {}
 
+#ifdef AsyncQueue_MULTITHREAD
     MessageQueueBuffer::MessageQueueBuffer(
-            MessageQueue &queue, MessageLevel lvl, const std::string &source)
-            : std::stringbuf(std::ios::out), m_queue(&queue), m_lvl(lvl), m_source(source) {}
+            MessageQueue &queue, MessageLevel lvl, SourceName source, std::stop_token st)
+            : m_queue(&queue), m_lvl(lvl), m_source(source), m_stopToken(std::move(st)) {}
+#endif
 
     MessageQueueBuffer::MessageQueueBuffer(MessageQueueBuffer &&other)
-            : std::stringbuf(std::move(other)), m_queue(other.m_queue), m_lvl(other.m_lvl),
-              m_source(other.m_source) {
+            : m_queue(other.m_queue), m_lvl(other.m_lvl), m_source(other.m_source),
+#ifdef AsyncQueue_MULTITHREAD
+              m_stopToken(other.m_stopToken),
+#endif
+              m_text(std::move(other.m_text)) {
+        resetPutArea(other.pptr() - other.pbase());
         // Set the other queue to null so it is unable to push
         other.m_queue = nullptr;
+        other.m_text.clear();
+        other.setp(nullptr, nullptr);
     }
 
+    MessageQueueBuffer::~MessageQueueBuffer() { MessageText::recycle(std::move(m_text)); }
+
     int MessageQueueBuffer::sync() {
-        if (m_queue && !str().empty())
-            m_queue->push(
-                    {.source = m_source,
-                     .time = std::chrono::system_clock::now(),
-                     .level = m_lvl,
-                     .message = str()});
-        // Empty the buffer
-        str("");
+        std::size_t used = pptr() - pbase();
+        if (m_queue && used > 0) {
+            m_text.resize(used);
+            Message message{
+                    .source = m_source,
+                    .time = std::chrono::system_clock::now(),
+                    .level = m_lvl,
+                    .message = MessageText(std::move(m_text))};
+#ifdef AsyncQueue_MULTITHREAD
+            // Nothing will consume the message once the token is stopped
+            if (!m_stopToken.stop_requested())
+                m_queue->push(std::move(message), m_stopToken);
+#else
+            m_queue->push(std::move(message));
+#endif
+        }
+        // Empty the buffer. A new string is only taken from the pool if more is written
+        m_text.clear();
+        setp(nullptr, nullptr);
         return 0;
     }
-} // namespace AsyncQueue
\ No newline at end of file
+
+    MessageQueueBuffer::int_type MessageQueueBuffer::overflow(int_type ch) {
+        if (!m_queue)
+            return traits_type::not_eof(ch);
+        std::size_t used = pptr() - pbase();
+        if (m_text.empty())
+            m_text = MessageText::acquire();
+        // Use all of the string's existing capacity before growing it
+        m_text.resize(std::max<std::size_t>({2 * m_text.size(), m_text.capacity(), 64}));
+        resetPutArea(used);
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    void MessageQueueBuffer::resetPutArea(std::size_t used) {
+        setp(m_text.data(), m_text.data() + m_text.size());
+        pbump(static_cast<int>(used));
+    }
+} // namespace AsyncQueue
@@ -4,9 +4,15 @@ namespace AsyncQueue {
     MessageQueueStream::MessageQueueStream() : std::ostream(&m_buffer) {}
 
     MessageQueueStream::MessageQueueStream(
-            MessageQueue &queue, MessageLevel lvl, const std::string &source)
+            MessageQueue &queue, MessageLevel lvl, SourceName source)
             : std::ostream(&m_buffer), m_buffer(queue, lvl, source) {}
 
+#ifdef AsyncQueue_MULTITHREAD
+    MessageQueueStream::MessageQueueStream(
+            MessageQueue &queue, MessageLevel lvl, SourceName source, std::stop_token st)
+            : std::ostream(&m_buffer), m_buffer(queue, lvl, source, std::move(st)) {}
+#endif
+
     MessageQueueStream::MessageQueueStream(MessageQueueStream &&other)
             : std::ostream(&m_buffer), m_buffer(std::move(other.m_buffer)) {}
 
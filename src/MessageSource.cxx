@@ -1,6 +1,7 @@
 #include "AsyncQueue/MessageSource.hxx"
 #include "AsyncQueue/AsyncQueue.hxx"
 
+#include <chrono>
 #include <sstream>
 #include <thread>
 
@@ -10,12 +11,23 @@ namespace AsyncQueue {
             const std::string &name, MessageQueue &queue, MessageLevel outputLvl)
             : m_queue(queue), m_name(name), m_outputLvl(outputLvl) {}
 
+#ifdef AsyncQueue_MULTITHREAD
+    MessageSource::MessageSource(
+            const std::string &name, MessageQueue &queue, MessageLevel outputLvl,
+            std::stop_token st)
+            : m_queue(queue), m_name(name), m_outputLvl(outputLvl), m_stopToken(std::move(st)) {}
+#endif
+
     MessageSource MessageSource::createSubSource(const std::string &subName) const {
         return createSubSource(subName, m_outputLvl);
     }
     MessageSource MessageSource::createSubSource(
             const std::string &subName, MessageLevel outputLvl) const {
-        return MessageSource(m_name + ":" + subName, m_queue, outputLvl);
+#ifdef AsyncQueue_MULTITHREAD
+        return MessageSource(m_name.str() + ":" + subName, m_queue, outputLvl, m_stopToken);
+#else
+        return MessageSource(m_name.str() + ":" + subName, m_queue, outputLvl);
+#endif
     }
     MessageSource MessageSource::createThreadSubSource() const {
         std::thread::id tid = std::this_thread::get_id();
@@ -24,8 +36,31 @@ namespace AsyncQueue {
         return createSubSource(oss.str());
     }
 
-    MessageQueueStream MessageSource::msg(MessageLevel lvl) const {
-        return testLevel(lvl) ? MessageQueueStream(m_queue, lvl, m_name) : MessageQueueStream();
+    MessageQueueStream MessageSource::stream(MessageLevel lvl) const {
+        // Only the runtime level is checked here. The compile time level has already been applied
+        // by the caller, which may have been built with a different one
+        if (m_outputLvl > lvl)
+            return MessageQueueStream();
+#ifdef AsyncQueue_MULTITHREAD
+        return MessageQueueStream(m_queue, lvl, m_name, m_stopToken);
+#else
+        return MessageQueueStream(m_queue, lvl, m_name);
+#endif
+    }
+
+    void MessageSource::push(MessageLevel lvl, MessageText &&text) const {
+        Message message{
+                .source = m_name,
+                .time = std::chrono::system_clock::now(),
+                .level = lvl,
+                .message = std::move(text)};
+#ifdef AsyncQueue_MULTITHREAD
+        // Nothing will consume the message once the token is stopped
+        if (!m_stopToken.stop_requested())
+            m_queue.push(std::move(message), m_stopToken);
+#else
+        m_queue.push(std::move(message));
+#endif
     }
 
 } // namespace AsyncQueue
\ No newline at end of file
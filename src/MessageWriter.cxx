@@ -1,5 +1,4 @@
 #include "AsyncQueue/MessageWriter.hxx"
-#include "AsyncQueue/MessageFormatter.hxx"
 
 #ifdef __cpp_lib_syncbuf
 #include <syncstream>
@@ -12,14 +11,26 @@ namespace AsyncQueue {
     MessageWriter::MessageWriter(std::ostream &os, formatter_t format, MessageLevel lvl)
             : m_os(os), m_lvl(lvl), m_format(format) {}
 
-    TaskStatus MessageWriter::consume(const Message &message) {
+    MessageWriter::MessageWriter(std::ostream &os, MessageFormatter formatter, MessageLevel lvl)
+            : m_os(os), m_lvl(lvl), m_formatter(std::move(formatter)) {}
+
+    TaskStatus MessageWriter::consume(std::span<const Message> messages) {
 #ifdef __cpp_lib_syncbuf
-        std::osyncstream(m_os)
+        std::osyncstream os(m_os);
 #else
-        m_os
+        std::ostream &os = m_os;
 #endif
-
-                << m_format(message);
+        // Format the whole batch into the buffer, whose capacity is kept between batches
+        m_buffer.clear();
+        for (const Message &message : messages) {
+            if (message.level < m_lvl)
+                continue;
+            if (m_formatter)
+                m_formatter->format(message, m_buffer);
+            else
+                m_buffer += m_format(message);
+        }
+        os.write(m_buffer.data(), m_buffer.size());
         return TaskStatus::CONTINUE;
     }
 } // namespace AsyncQueue
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "AsyncQueue/QueueStats.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace AsyncQueue {
+    void LatencyHistogram::record(duration d) {
+        std::uint64_t ns = d.count() > 0 ? static_cast<std::uint64_t>(d.count()) : 0;
+        ++m_buckets[bucketIndex(duration(ns))];
+        m_min = m_count == 0 ? ns : std::min(m_min, ns);
+        m_max = std::max(m_max, ns);
+        m_sum += ns;
+        ++m_count;
+    }
+
+    LatencyHistogram &LatencyHistogram::operator+=(const LatencyHistogram &other) {
+        if (other.m_count == 0)
+            return *this;
+        for (std::size_t idx = 0; idx < nBuckets; ++idx)
+            m_buckets[idx] += other.m_buckets[idx];
+        m_min = m_count == 0 ? other.m_min : std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+        m_sum += other.m_sum;
+        m_count += other.m_count;
+        return *this;
+    }
+
+    void LatencyHistogram::clear() { *this = LatencyHistogram(); }
+
+    LatencyHistogram::duration LatencyHistogram::min() const { return duration(m_min); }
+
+    LatencyHistogram::duration LatencyHistogram::mean() const {
+        return duration(m_count == 0 ? 0 : m_sum / m_count);
+    }
+
+    LatencyHistogram::duration LatencyHistogram::percentile(double percent) const {
+        if (m_count == 0)
+            return duration::zero();
+        // The rank of the percentile, counting from 1
+        auto rank = static_cast<std::uint64_t>(
+                std::ceil(std::clamp(percent, 0.0, 100.0) / 100 * m_count));
+        rank = std::max<std::uint64_t>(rank, 1);
+        std::uint64_t seen = 0;
+        for (std::size_t idx = 0; idx < nBuckets; ++idx) {
+            seen += m_buckets[idx];
+            if (seen >= rank)
+                return std::clamp(bucketUpperBound(idx), min(), max());
+        }
+        return max();
+    }
+
+    LatencyHistogram::duration LatencyHistogram::bucketLowerBound(std::size_t index) {
+        if (index < subBuckets)
+            return duration(index);
+        // The first subBuckets buckets hold single values, after that each group of subBuckets
+        // covers the next power of two
+        unsigned shift = index / subBuckets - 1;
+        return duration((subBuckets + index % subBuckets) << shift);
+    }
+
+    LatencyHistogram::duration LatencyHistogram::bucketUpperBound(std::size_t index) {
+        if (index < subBuckets)
+            return duration(index);
+        unsigned shift = index / subBuckets - 1;
+        return duration(
+                ((subBuckets + index % subBuckets) << shift) + ((std::uint64_t{1} << shift) - 1));
+    }
+
+    std::size_t LatencyHistogram::bucketIndex(duration d) {
+        auto ns = static_cast<std::uint64_t>(d.count());
+        if (ns < subBuckets)
+            return ns;
+        unsigned shift = std::bit_width(ns) - 1 - subBucketBits;
+        return (shift + 1) * subBuckets + ((ns >> shift) - subBuckets);
+    }
+} // namespace AsyncQueue
@@ -0,0 +1,54 @@
+#include "AsyncQueue/SourceRegistry.hxx"
+
+#include <algorithm>
+
+namespace AsyncQueue {
+    SourceRegistry &SourceRegistry::global() {
+        // Deliberately leaked so that it outlives any static object which logs on destruction
+        static SourceRegistry *registry = new SourceRegistry();
+        return *registry;
+    }
+
+    SourceId SourceRegistry::intern(std::string_view name) {
+        std::lock_guard lock(m_mutex);
+        if (auto itr = m_ids.find(name); itr != m_ids.end())
+            return itr->second;
+        if (m_names.size() >= m_capacity)
+            return invalidSourceId;
+        SourceId id = static_cast<SourceId>(m_names.size());
+        const std::string &stored = m_names.emplace_back(name);
+        m_ids.emplace(stored, id);
+        return id;
+    }
+
+    std::string_view SourceRegistry::name(SourceId id) const {
+        std::lock_guard lock(m_mutex);
+        return id < m_names.size() ? std::string_view(m_names[id]) : std::string_view();
+    }
+
+    std::size_t SourceRegistry::size() const {
+        std::lock_guard lock(m_mutex);
+        return m_names.size();
+    }
+
+    std::size_t SourceRegistry::capacity() const {
+        std::lock_guard lock(m_mutex);
+        return m_capacity;
+    }
+
+    void SourceRegistry::setCapacity(std::size_t capacity) {
+        std::lock_guard lock(m_mutex);
+        // IDs must be representable, and distinct from invalidSourceId
+        m_capacity = std::min<std::size_t>(capacity, invalidSourceId);
+    }
+
+    SourceName::SourceName(std::string_view name)
+            : SourceName(SourceRegistry::global().intern(name)) {
+        if (m_id == invalidSourceId) {
+            m_owned = std::make_shared<const std::string>(name);
+            m_name = *m_owned;
+        }
+    }
+
+    SourceName::SourceName(SourceId id) : m_id(id), m_name(SourceRegistry::global().name(id)) {}
+} // namespace AsyncQueue
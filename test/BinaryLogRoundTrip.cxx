@@ -0,0 +1,124 @@
+/**
+ * @file BinaryLogRoundTrip.cxx
+ * @brief Messages written by a BinaryMessageWriter must be read back unchanged
+ *
+ * Writes several batches with a small segment size so that the log rotates, and checks that
+ * every segment can be read on its own (so each starts its own source dictionary), that a
+ * truncated final record is skipped and that a restarted writer continues after the highest
+ * existing segment.
+ */
+
+#include "Check.hxx"
+
+#include "AsyncQueue/BinaryLog.hxx"
+#include "AsyncQueue/BinaryMessageWriter.hxx"
+#include "AsyncQueue/Message.hxx"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+    using namespace AsyncQueue;
+    namespace fs = std::filesystem;
+
+    constexpr std::size_t nBatches = 8;
+    constexpr std::size_t batchSize = 5;
+    /// @brief Small enough that the log rotates every couple of batches
+    constexpr std::size_t maxSegmentSize = 256;
+
+    /// @brief The fields of a message which are stored in the log
+    struct Expected {
+        std::string source;
+        std::chrono::system_clock::time_point time;
+        MessageLevel level;
+        std::string text;
+    };
+
+    /// @brief Create a batch of messages with varying sources, levels and text lengths
+    std::vector<Message> makeBatch(std::size_t batch, std::vector<Expected> &expected) {
+        static const char *sources[] = {"Alpha", "Beta", "Alpha:Sub"};
+        std::vector<Message> messages;
+        for (std::size_t idx = 0; idx < batchSize; ++idx) {
+            std::size_t n = batch * batchSize + idx;
+            Expected &e = expected.emplace_back(Expected{
+                    .source = sources[n % 3],
+                    .time = std::chrono::system_clock::time_point(
+                            std::chrono::nanoseconds(1700000000123456789 + n * 1001)),
+                    .level = static_cast<MessageLevel>(n % 6),
+                    .text = "message " + std::to_string(n) + std::string(n % 7, '.')});
+            messages.push_back(
+                    {.source = e.source, .time = e.time, .level = e.level, .message = e.text});
+        }
+        return messages;
+    }
+
+    /// @brief Read every segment of the log, each with a fresh reader
+    std::vector<Expected> readLog(const std::string &prefix) {
+        std::vector<Expected> read;
+        for (const std::string &path : findBinaryLogSegments(prefix)) {
+            BinaryLogSegment segment(path);
+            segment.forEach([&read](const BinaryLogRecord &record) {
+                read.push_back(Expected{
+                        .source = std::string(record.source),
+                        .time = record.time,
+                        .level = record.level,
+                        .text = std::string(record.text)});
+            });
+        }
+        return read;
+    }
+
+    void checkEqual(const std::vector<Expected> &read, const std::vector<Expected> &expected) {
+        ASYNCQUEUE_CHECK(read.size() == expected.size());
+        for (std::size_t idx = 0; idx < read.size(); ++idx) {
+            ASYNCQUEUE_CHECK(read[idx].source == expected[idx].source);
+            ASYNCQUEUE_CHECK(read[idx].time == expected[idx].time);
+            ASYNCQUEUE_CHECK(read[idx].level == expected[idx].level);
+            ASYNCQUEUE_CHECK(read[idx].text == expected[idx].text);
+        }
+    }
+} // namespace
+
+int main() {
+    fs::path dir = fs::temp_directory_path() /
+                   ("AsyncQueueBinaryLogRoundTrip." + std::to_string(::getpid()));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const std::string prefix = (dir / "log").string();
+
+    std::vector<Expected> expected;
+    std::string lastSegment;
+    {
+        BinaryMessageWriter writer(prefix, MessageLevel::VERBOSE, maxSegmentSize);
+        for (std::size_t batch = 0; batch < nBatches; ++batch)
+            writer.consume(makeBatch(batch, expected));
+        ASYNCQUEUE_CHECK(writer.droppedMessages() == 0);
+        lastSegment = writer.segmentPath();
+    }
+    std::vector<std::string> segments = findBinaryLogSegments(prefix);
+    ASYNCQUEUE_CHECK(segments.size() > 2);
+    ASYNCQUEUE_CHECK(segments.back() == lastSegment);
+    checkEqual(readLog(prefix), expected);
+
+    // Cut the last record short, as if the writer had been interrupted part way through it
+    fs::resize_file(lastSegment, fs::file_size(lastSegment) - 3);
+    expected.pop_back();
+    checkEqual(readLog(prefix), expected);
+
+    // A new writer must leave the existing segments alone and start after the last of them
+    {
+        BinaryMessageWriter writer(prefix, MessageLevel::VERBOSE, maxSegmentSize);
+        ASYNCQUEUE_CHECK(writer.segmentPath() == binaryLogSegmentPath(prefix, segments.size()));
+        writer.consume(makeBatch(nBatches, expected));
+        ASYNCQUEUE_CHECK(writer.droppedMessages() == 0);
+    }
+    ASYNCQUEUE_CHECK(findBinaryLogSegments(prefix).size() == segments.size() + 1);
+    checkEqual(readLog(prefix), expected);
+
+    fs::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file Check.hxx
+ * @brief Assertions for the tests, which unlike assert are kept in NDEBUG builds
+ */
+
+#ifndef ASYNCQUEUE_TEST_CHECK_HXX
+#define ASYNCQUEUE_TEST_CHECK_HXX
+
+#include <cstdio>
+#include <cstdlib>
+#include <source_location>
+
+namespace AsyncQueue::test {
+    /// @brief Report a failed check and exit. _Exit is used as threads may still be blocked
+    [[noreturn]] inline void fail(const char *what, std::source_location where) {
+        std::fprintf(
+                stderr, "%s:%u: check failed: %s\n", where.file_name(),
+                static_cast<unsigned>(where.line()), what);
+        std::fflush(stderr);
+        std::_Exit(EXIT_FAILURE);
+    }
+
+    inline void check(
+            bool condition, const char *what,
+            std::source_location where = std::source_location::current()) {
+        if (!condition)
+            fail(what, where);
+    }
+} // namespace AsyncQueue::test
+
+/// @brief Exit with a failure if condition is false
+#define ASYNCQUEUE_CHECK(condition) ::AsyncQueue::test::check((condition), #condition)
+
+#endif //> !ASYNCQUEUE_TEST_CHECK_HXX
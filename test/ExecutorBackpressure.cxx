@@ -0,0 +1,69 @@
+/**
+ * @file ExecutorBackpressure.cxx
+ * @brief Bulk pushes into a full queue must wake a consumer parked on an executor
+ *
+ * A consumer running on an executor parks itself with onElementReady when it finds the queue
+ * empty. A bulk push only notifies consumers once it has finished, so if it fills the queue part
+ * way through it must still wake the parked consumer before waiting for space.
+ */
+
+#include "Check.hxx"
+
+#include "AsyncQueue/AsyncQueue.hxx"
+#include "AsyncQueue/Executor.hxx"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace {
+    using namespace AsyncQueue;
+    using namespace std::chrono_literals;
+
+    constexpr std::size_t capacity = 4;
+    constexpr std::size_t nElements = 10;
+
+    /// @brief Fill a bounded queue with a bulk push while its only consumer is parked
+    template <typename Push> void checkBulkPush(Push &&push) {
+        Executor executor(2);
+        ::AsyncQueue::AsyncQueue<long> queue;
+        queue.setCapacity(capacity, OverflowPolicy::Block);
+        std::stop_source ss;
+        std::atomic<std::size_t> consumed{0};
+        auto consumer = queue.loopConsumer(executor, ss, [&consumed](const long &) {
+            consumed.fetch_add(1);
+            return TaskStatus::CONTINUE;
+        });
+        // Give the consumer time to find the queue empty and park
+        std::this_thread::sleep_for(50ms);
+
+        std::vector<long> values(nElements);
+        std::iota(values.begin(), values.end(), 0);
+        auto pushed = std::async(std::launch::async, [&]() { return push(queue, values); });
+        ASYNCQUEUE_CHECK(pushed.wait_for(10s) == std::future_status::ready);
+        ASYNCQUEUE_CHECK(pushed.get() == nElements);
+        auto deadline = std::chrono::steady_clock::now() + 10s;
+        while (consumed.load() < nElements && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(1ms);
+        ASYNCQUEUE_CHECK(consumed.load() == nElements);
+        ss.request_stop();
+        ASYNCQUEUE_CHECK(consumer.get() == TaskStatus::CONTINUE);
+    }
+} // namespace
+
+int main() {
+    checkBulkPush([](auto &queue, const std::vector<long> &values) {
+        return queue.pushRange(values);
+    });
+    checkBulkPush([](auto &queue, const std::vector<long> &values) {
+        std::stop_source ss;
+        return queue.pushRange(values.begin(), values.end(), ss.get_token());
+    });
+    checkBulkPush([](auto &queue, std::vector<long> values) {
+        return queue.pushBulk(std::move(values));
+    });
+    return 0;
+}
@@ -0,0 +1,233 @@
+/**
+ * @file FileMessageWriter.cxx
+ * @brief A FileMessageWriter must rotate, flush and recover from write failures correctly
+ *
+ * Rotation is checked by size, including that pruning only removes files which the writer
+ * rotated itself. A full disk is simulated by lowering the file size limit of the process, which
+ * makes writes fail with EFBIG until it is raised again.
+ */
+
+#include "Check.hxx"
+
+#include "AsyncQueue/FileMessageWriter.hxx"
+#include "AsyncQueue/Message.hxx"
+
+#ifdef AsyncQueue_MULTITHREAD
+#include "AsyncQueue/Executor.hxx"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace {
+    using namespace AsyncQueue;
+    namespace fs = std::filesystem;
+    using namespace std::chrono_literals;
+
+    /// @brief Small enough that the file rotates every few messages
+    constexpr std::size_t maxFileSize = 256;
+    constexpr int nMessages = 30;
+
+    std::string text(int idx) { return "message " + std::to_string(idx) + ";"; }
+
+    void consume(FileMessageWriter &writer, int idx, MessageLevel lvl = MessageLevel::INFO) {
+        Message message{
+                .source = "Writer",
+                .time = std::chrono::system_clock::now(),
+                .level = lvl,
+                .message = text(idx)};
+        writer.consume(std::span<const Message>(&message, 1));
+    }
+
+    std::string read(const fs::path &path) {
+        std::ifstream is(path);
+        return std::string(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+
+    /// @brief The rotated files of base, oldest first
+    /// @param base The file being rotated
+    /// @param others Names of files which look similar but were not rotated
+    std::vector<fs::path> rotatedFiles(
+            const fs::path &base, const std::vector<std::string> &others = {}) {
+        // Sort by the time stamp and then by the counter added to files rotated in the same second
+        std::vector<std::tuple<std::string, std::size_t, fs::path>> rotated;
+        std::string prefix = base.filename().string() + ".";
+        for (const auto &entry : fs::directory_iterator(base.parent_path())) {
+            std::string name = entry.path().filename().string();
+            if (!name.starts_with(prefix) ||
+                std::find(others.begin(), others.end(), name) != others.end())
+                continue;
+            std::string suffix = name.substr(prefix.size());
+            std::size_t dash = suffix.find('-');
+            std::size_t counter =
+                    dash == std::string::npos ? 0 : std::stoul(suffix.substr(dash + 1));
+            rotated.emplace_back(suffix.substr(0, dash), counter, entry.path());
+        }
+        std::sort(rotated.begin(), rotated.end());
+        std::vector<fs::path> paths;
+        for (const auto &entry : rotated)
+            paths.push_back(std::get<2>(entry));
+        return paths;
+    }
+
+    /// @brief Check that the messages [first, last) appear in order in the text
+    void checkMessages(const std::string &contents, int first, int last) {
+        std::size_t pos = 0;
+        for (int idx = first; idx < last; ++idx) {
+            pos = contents.find(text(idx), pos);
+            ASYNCQUEUE_CHECK(pos != std::string::npos);
+        }
+    }
+
+    /// @brief No file may grow beyond the maximum size and no message may be lost or reordered
+    void checkRotation(const fs::path &dir) {
+        fs::path base = dir / "rotated.log";
+        FileWriterOptions options{.flushLevel = MessageLevel::VERBOSE, .maxFileSize = maxFileSize};
+        {
+            FileMessageWriter writer(base.string(), options);
+            for (int idx = 0; idx < nMessages; ++idx)
+                consume(writer, idx);
+            ASYNCQUEUE_CHECK(writer.droppedMessages() == 0);
+        }
+        std::vector<fs::path> files = rotatedFiles(base);
+        ASYNCQUEUE_CHECK(files.size() > 2);
+        files.push_back(base);
+        std::string contents;
+        for (const fs::path &file : files) {
+            ASYNCQUEUE_CHECK(fs::file_size(file) <= maxFileSize);
+            contents += read(file);
+        }
+        checkMessages(contents, 0, nMessages);
+    }
+
+    /// @brief Only the newest rotated files are kept, and other files next to them are left alone
+    void checkPrune(const fs::path &dir) {
+        fs::path base = dir / "pruned.log";
+        const std::vector<std::string> others = {
+                "pruned.log.1",
+                "pruned.log.txt",
+                "pruned.log.20240101T000000Z.bak",
+                "pruned.log.20240101T000000Z-x",
+                "pruned.log.2024010lT000000Z",
+                "pruned.logs.20240101T000000Z",
+                "other.log.20240101T000000Z"};
+        for (const std::string &name : others)
+            std::ofstream(dir / name) << "keep\n";
+        FileWriterOptions options{
+                .flushLevel = MessageLevel::VERBOSE,
+                .maxFileSize = maxFileSize,
+                .maxRotatedFiles = 2};
+        {
+            FileMessageWriter writer(base.string(), options);
+            for (int idx = 0; idx < nMessages; ++idx)
+                consume(writer, idx);
+        }
+        std::vector<fs::path> files = rotatedFiles(base, others);
+        ASYNCQUEUE_CHECK(files.size() == 2);
+        for (const std::string &name : others)
+            ASYNCQUEUE_CHECK(fs::exists(dir / name));
+        // The kept files are the newest, so they hold the last messages
+        files.push_back(base);
+        std::string contents;
+        for (const fs::path &file : files)
+            contents += read(file);
+        ASYNCQUEUE_CHECK(contents.find(text(0)) == std::string::npos);
+        checkMessages(contents, nMessages - 2, nMessages);
+    }
+
+    /// @brief Text is kept while the file can't be written, then discarded once the buffer is
+    ///        full. When writing succeeds again the discarded messages are reported
+    void checkDiskFull(const fs::path &dir) {
+        fs::path base = dir / "full.log";
+        FileWriterOptions options{
+                .bufferSize = 128, .flushInterval = 1h, .flushLevel = MessageLevel::ABORT};
+        rlimit original;
+        ASYNCQUEUE_CHECK(::getrlimit(RLIMIT_FSIZE, &original) == 0);
+        std::signal(SIGXFSZ, SIG_IGN);
+        FileMessageWriter writer(base.string(), options);
+
+        // Nothing can be reported while the limit is in place, in case stderr is a file
+        rlimit full = original;
+        full.rlim_cur = 0;
+        ASYNCQUEUE_CHECK(::setrlimit(RLIMIT_FSIZE, &full) == 0);
+        consume(writer, 0);
+        bool flushedFirst = writer.flush();
+        std::size_t droppedFirst = writer.droppedMessages();
+        for (int idx = 1; idx < nMessages; ++idx)
+            consume(writer, idx);
+        bool flushed = writer.flush();
+        std::size_t dropped = writer.droppedMessages();
+        ASYNCQUEUE_CHECK(::setrlimit(RLIMIT_FSIZE, &original) == 0);
+        ASYNCQUEUE_CHECK(!flushedFirst);
+        ASYNCQUEUE_CHECK(droppedFirst == 0);
+        ASYNCQUEUE_CHECK(!flushed);
+        ASYNCQUEUE_CHECK(dropped > 0);
+        ASYNCQUEUE_CHECK(fs::file_size(base) == 0);
+
+        // Enough to overflow the buffer, so that some are written directly
+        for (int idx = nMessages; idx < 2 * nMessages; ++idx)
+            consume(writer, idx);
+        ASYNCQUEUE_CHECK(writer.flush());
+        ASYNCQUEUE_CHECK(writer.droppedMessages() == dropped);
+        // The notice comes first, followed by everything after the discarded messages
+        std::string contents = read(base);
+        ASYNCQUEUE_CHECK(contents.starts_with(
+                "FileMessageWriter: " + std::to_string(dropped) + " messages were discarded"));
+        ASYNCQUEUE_CHECK(contents.find(text(0)) == std::string::npos);
+        checkMessages(contents, static_cast<int>(dropped), 2 * nMessages);
+    }
+
+#ifdef AsyncQueue_MULTITHREAD
+    /// @brief Buffered text is written once the flush interval passes without further messages
+    void checkFlushInterval(const fs::path &dir, Executor *executor) {
+        fs::path base = dir / (executor ? "interval.log" : "default.log");
+        FileWriterOptions options{.flushInterval = 100ms, .executor = executor};
+        FileMessageWriter writer(base.string(), options);
+        consume(writer, 0);
+        ASYNCQUEUE_CHECK(fs::file_size(base) == 0);
+        // Messages at the flush level are written immediately, with any text before them
+        consume(writer, 1, MessageLevel::ERROR);
+        checkMessages(read(base), 0, 2);
+        consume(writer, 2);
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (read(base).find(text(2)) == std::string::npos) {
+            ASYNCQUEUE_CHECK(std::chrono::steady_clock::now() < deadline);
+            std::this_thread::sleep_for(10ms);
+        }
+        checkMessages(read(base), 0, 3);
+    }
+#endif
+} // namespace
+
+int main() {
+    fs::path dir = fs::temp_directory_path() /
+                   ("AsyncQueueFileMessageWriter." + std::to_string(::getpid()));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    checkRotation(dir);
+    checkPrune(dir);
+    checkDiskFull(dir);
+#ifdef AsyncQueue_MULTITHREAD
+    {
+        Executor executor(1);
+        checkFlushInterval(dir, &executor);
+    }
+    checkFlushInterval(dir, nullptr);
+#endif
+
+    fs::remove_all(dir);
+    return 0;
+}
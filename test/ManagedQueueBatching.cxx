@@ -0,0 +1,129 @@
+/**
+ * @file ManagedQueueBatching.cxx
+ * @brief A ManagedQueue must deliver every element in order to both kinds of consumer
+ *
+ * Batch consumers receive the elements grouped according to their batch options, other consumers
+ * one at a time. A consumer which halts part way through a batch must leave the elements it did
+ * not reach in the queue, as it would if the elements were extracted one at a time.
+ */
+
+#include "Check.hxx"
+
+#include "AsyncQueue/Executor.hxx"
+#include "AsyncQueue/IBatchConsumer.hxx"
+#include "AsyncQueue/IConsumer.hxx"
+#include "AsyncQueue/ManagedQueue.hxx"
+#include "AsyncQueue/RingBufferQueue.hxx"
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <span>
+#include <vector>
+
+namespace {
+    using namespace AsyncQueue;
+
+    constexpr long nElements = 1000;
+    constexpr std::size_t maxBatch = 8;
+    /// @brief The consumers which halt do so on this element
+    constexpr long haltAt = 5;
+    constexpr long nHalted = 20;
+
+    std::vector<long> iota(long first, long last) {
+        std::vector<long> values(last - first);
+        std::iota(values.begin(), values.end(), first);
+        return values;
+    }
+
+    /// @brief Consumer which records each element, optionally halting on one of them
+    class Recorder : public IConsumer<long> {
+    public:
+        Recorder(long halt = -1) : m_halt(halt) {}
+        TaskStatus consume(const long &element) override {
+            values.push_back(element);
+            return element == m_halt ? TaskStatus::HALT : TaskStatus::CONTINUE;
+        }
+        std::vector<long> values;
+
+    private:
+        long m_halt;
+    };
+
+    /// @brief Batch consumer which records each batch
+    class BatchRecorder : public IBatchConsumer<long> {
+    public:
+        BatchRecorder() : IBatchConsumer<long>(BatchOptions{.maxSize = maxBatch}) {}
+        using IBatchConsumer<long>::consume;
+        TaskStatus consume(std::span<const long> elements) override {
+            values.insert(values.end(), elements.begin(), elements.end());
+            largestBatch = std::max(largestBatch, elements.size());
+            return TaskStatus::CONTINUE;
+        }
+        std::vector<long> values;
+        std::size_t largestBatch{0};
+    };
+
+    /// @brief Push with each bulk method and check that the batches respect the options
+    void checkBatchConsumer() {
+        BatchRecorder consumer;
+        {
+            ManagedQueue<long> queue(&consumer);
+            ASYNCQUEUE_CHECK(queue.pushBulk(iota(0, nElements / 2)) == nElements / 2);
+            ASYNCQUEUE_CHECK(queue.pushRange(iota(nElements / 2, nElements)) == nElements / 2);
+        }
+        ASYNCQUEUE_CHECK(consumer.values == iota(0, nElements));
+        ASYNCQUEUE_CHECK(consumer.largestBatch <= maxBatch);
+    }
+
+    /// @brief A consumer which doesn't accept batches receives every element in order
+    void checkElementConsumer() {
+        Recorder consumer;
+        {
+            ManagedQueue<long> queue(&consumer);
+            ASYNCQUEUE_CHECK(queue.pushBulk(iota(0, nElements / 2)) == nElements / 2);
+            for (long value = nElements / 2; value < nElements; ++value)
+                ASYNCQUEUE_CHECK(queue.push(value));
+        }
+        ASYNCQUEUE_CHECK(consumer.values == iota(0, nElements));
+    }
+
+    /// @brief After a halt the elements the consumer never saw must still be in the queue
+    template <typename Queue> void checkHalt(Queue &queue, Recorder &consumer) {
+        ASYNCQUEUE_CHECK(queue.pushBulk(iota(0, nHalted)) == nHalted);
+        ASYNCQUEUE_CHECK(queue.consumerStatus().get() == TaskStatus::HALT);
+        ASYNCQUEUE_CHECK(consumer.values == iota(0, haltAt + 1));
+        ASYNCQUEUE_CHECK(queue.size() == nHalted - haltAt - 1);
+        for (long expected = haltAt + 1; expected < nHalted; ++expected)
+            ASYNCQUEUE_CHECK(queue.extract() == expected);
+    }
+
+    void checkHaltThread() {
+        Recorder consumer(haltAt);
+        ManagedQueue<long> queue(&consumer);
+        checkHalt(queue, consumer);
+    }
+
+    void checkHaltExecutor() {
+        Executor executor(1);
+        Recorder consumer(haltAt);
+        ManagedQueue<long> queue(executor, std::stop_source(), &consumer);
+        checkHalt(queue, consumer);
+    }
+
+    /// @brief A queue which can't take elements back is drained one element at a time instead
+    void checkHaltRingBuffer() {
+        Recorder consumer(haltAt);
+        ManagedQueue<long, MPMCQueue<long, 64>> queue(std::stop_source(), &consumer);
+        checkHalt(queue, consumer);
+    }
+} // namespace
+
+int main() {
+    checkBatchConsumer();
+    checkElementConsumer();
+    checkHaltThread();
+    checkHaltExecutor();
+    checkHaltRingBuffer();
+    return 0;
+}
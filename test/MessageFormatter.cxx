@@ -0,0 +1,276 @@
+/**
+ * @file MessageFormatter.cxx
+ * @brief The compiled MessageFormatter must produce the same text as the original formatter
+ *
+ * The original implementation, which formatted every field of every message from scratch, is
+ * kept here as the reference. Messages are formatted within the same second and across seconds so
+ * that both the cached and the recomputed time text are compared. The original only supported a
+ * single message field, so with several message fields the reference is applied with each of the
+ * later ones replaced by the current line.
+ */
+
+#include "Check.hxx"
+
+#include "AsyncQueue/Message.hxx"
+#include "AsyncQueue/MessageFormatter.hxx"
+
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    using namespace AsyncQueue;
+    using Field = MessageFormatter::Field;
+    using FieldType = MessageFormatter::FieldType;
+
+    /// @name Reference implementation
+    /// @{
+    template <typename Clock>
+    std::string referenceTime(const std::chrono::time_point<Clock> &timepoint, std::string format) {
+        auto seconds = std::chrono::floor<std::chrono::seconds>(timepoint);
+        if (format.find("%+") != std::string::npos) {
+            std::size_t pos = format.find("%+");
+            auto diff = timepoint - seconds;
+            while (pos != std::string::npos) {
+                if (pos + 2 >= format.size())
+                    break;
+                char code = format.at(pos + 2);
+                std::size_t count;
+                if (code == 'n')
+                    count = std::chrono::duration_cast<std::chrono::nanoseconds>(diff).count();
+                else if (code == 'u')
+                    count = std::chrono::duration_cast<std::chrono::microseconds>(diff).count();
+                else if (code == 'm')
+                    count = std::chrono::duration_cast<std::chrono::milliseconds>(diff).count();
+                else
+                    break;
+                format = format.replace(pos, 3, std::to_string(count));
+                pos = format.find("%+", pos);
+            }
+        }
+        std::ostringstream oss;
+        std::time_t tmt = Clock::to_time_t(seconds);
+        oss << std::put_time(std::localtime(&tmt), format.c_str());
+        return oss.str();
+    }
+
+    std::string referenceField(const Message &message, const Field &field) {
+        std::string value = "";
+        switch (field.type) {
+        case FieldType::Name:
+            value = message.source.str();
+            break;
+        case FieldType::Level:
+            value = toString(message.level);
+            break;
+        case FieldType::Time:
+            value = referenceTime(message.time, field.extra);
+            break;
+        case FieldType::Message:
+            value = message.message.str();
+            break;
+        case FieldType::Literal:
+            value = field.extra;
+            break;
+        }
+        if (field.minLength > value.size())
+            value.append(field.minLength - value.size(), ' ');
+        return value;
+    }
+
+    std::string referenceFormat(
+            const std::vector<Field> &fields, const std::string &sep, const Message &message) {
+        std::string value = "";
+        if (fields.size() == 0)
+            return value;
+        std::string prefix;
+        std::string suffix;
+        bool seenMsg = false;
+        for (const Field &field : fields) {
+            if (!seenMsg) {
+                if (!prefix.empty())
+                    prefix += sep;
+                if (field.type == FieldType::Message)
+                    seenMsg = true;
+                else
+                    prefix += referenceField(message, field);
+            } else
+                suffix += sep + referenceField(message, field);
+        }
+        const std::string text = message.message.str();
+        std::size_t pos = 0;
+        while (true) {
+            std::size_t next = text.find('\n', pos);
+            value += prefix + text.substr(pos, next - pos) + suffix + '\n';
+            if (next >= text.size() - 1)
+                break;
+            else
+                pos = next + 1;
+        }
+        return value;
+    }
+
+    /// @brief The reference, extended to any number of message fields
+    ///
+    /// Each line is formatted separately, with the message fields after the first replaced by
+    /// literals holding that line.
+    std::string referenceFormatLines(
+            const std::vector<Field> &fields, const std::string &sep, const Message &message) {
+        const std::string text = message.message.str();
+        std::string value;
+        std::size_t pos = 0;
+        while (true) {
+            std::size_t next = text.find('\n', pos);
+            std::string line = text.substr(pos, next - pos);
+            std::vector<Field> lineFields;
+            bool seenMsg = false;
+            for (const Field &field : fields) {
+                if (field.type == FieldType::Message && seenMsg)
+                    lineFields.push_back(Field{FieldType::Literal, field.minLength, line});
+                else
+                    lineFields.push_back(field);
+                seenMsg |= field.type == FieldType::Message;
+            }
+            Message lineMessage{
+                    .source = message.source,
+                    .time = message.time,
+                    .level = message.level,
+                    .message = line};
+            value += referenceFormat(lineFields, sep, lineMessage);
+            if (next >= text.size() - 1)
+                break;
+            else
+                pos = next + 1;
+        }
+        return value;
+    }
+    /// @}
+
+    /// @brief Messages with a variety of sources, levels, texts and times
+    std::vector<Message> makeMessages() {
+        using namespace std::chrono_literals;
+        const std::vector<std::string> texts = {
+                "single line", "first\nsecond\nthird", "trailing newline\n", "", "\n",
+                "a\n\nb"};
+        const std::vector<std::string> sources = {"Src", "AVeryLongSourceName:Sub", ""};
+        // Several messages in each second, then a jump to the next
+        auto time = std::chrono::system_clock::time_point(1700000000s) + 123456789ns;
+        std::vector<Message> messages;
+        for (std::size_t idx = 0; idx < 24; ++idx) {
+            messages.push_back(
+                    {.source = sources[idx % sources.size()],
+                     .time = time,
+                     .level = static_cast<MessageLevel>(idx % 6),
+                     .message = texts[idx % texts.size()]});
+            time += idx % 4 == 3 ? 1s + 7ms : 1234567ns;
+        }
+        return messages;
+    }
+
+    /// @brief Check each way of formatting against the expected text
+    void checkFormatter(
+            MessageFormatter &formatter, const std::vector<Message> &messages, auto &&expected) {
+        std::string appended;
+        std::string allExpected;
+        for (const Message &message : messages) {
+            std::string text = expected(message);
+            ASYNCQUEUE_CHECK(formatter.format(message) == text);
+            ASYNCQUEUE_CHECK(formatter(message) == text);
+            formatter.format(message, appended);
+            allExpected += text;
+        }
+        ASYNCQUEUE_CHECK(appended == allExpected);
+    }
+
+    void checkDefault(const std::vector<Message> &messages) {
+        MessageFormatter formatter;
+        std::vector<Field> fields = {
+                MessageFormatter::defaultNameField, MessageFormatter::defaultLevelField,
+                MessageFormatter::defaultTimeField, MessageFormatter::defaultMessageField};
+        checkFormatter(formatter, messages, [&](const Message &message) {
+            return referenceFormat(fields, " ", message);
+        });
+        for (const Message &message : messages)
+            for (const Field &field : fields)
+                ASYNCQUEUE_CHECK(
+                        MessageFormatter::formatField(message, field) ==
+                        referenceField(message, field));
+    }
+
+    /// @brief Separators, literals, time formats and fields after the message
+    void checkCustom(const std::vector<Message> &messages) {
+        const std::vector<std::vector<Field>> plans = {
+                {{FieldType::Literal, 0, ""},
+                 {FieldType::Level, 0, ""},
+                 {FieldType::Time, 0, "%H:%M:%S.%+m"},
+                 {FieldType::Message, 0, ""},
+                 {FieldType::Name, 12, ""}},
+                {{FieldType::Message, 0, ""},
+                 {FieldType::Literal, 6, "from"},
+                 {FieldType::Name, 0, ""},
+                 {FieldType::Time, 0, "%Y-%m-%d %+n ns %+u us %+x"}},
+                {{FieldType::Time, 40, "%s.%+u"},
+                 {FieldType::Literal, 0, "["},
+                 {FieldType::Name, 0, ""},
+                 {FieldType::Literal, 0, "]"},
+                 {FieldType::Message, 0, ""}}};
+        for (const std::string sep : {" | ", "", "\t", ", "})
+            for (const std::vector<Field> &fields : plans) {
+                MessageFormatter formatter(fields, sep);
+                checkFormatter(formatter, messages, [&](const Message &message) {
+                    return referenceFormat(fields, sep, message);
+                });
+            }
+    }
+
+    /// @brief Every message field is replaced by the current line
+    void checkMultipleMessageFields(const std::vector<Message> &messages) {
+        const std::vector<Field> fields = {
+                {FieldType::Level, 8, ""},
+                {FieldType::Message, 0, ""},
+                {FieldType::Literal, 0, "<->"},
+                {FieldType::Message, 0, ""},
+                {FieldType::Name, 0, ""},
+                {FieldType::Message, 0, ""}};
+        for (const std::string sep : {" ", ":"}) {
+            MessageFormatter formatter(fields, sep);
+            checkFormatter(formatter, messages, [&](const Message &message) {
+                return referenceFormatLines(fields, sep, message);
+            });
+        }
+        Message message{
+                .source = "Src",
+                .time = std::chrono::system_clock::now(),
+                .level = MessageLevel::INFO,
+                .message = "one\ntwo"};
+        MessageFormatter formatter(
+                {{FieldType::Message, 0, ""},
+                 {FieldType::Literal, 0, "="},
+                 {FieldType::Message, 0, ""}},
+                " ");
+        ASYNCQUEUE_CHECK(formatter.format(message) == "one = one\ntwo = two\n");
+    }
+
+    /// @brief Without a message field only the other fields are written
+    void checkNoMessageField() {
+        Message message{
+                .source = "Src",
+                .time = std::chrono::system_clock::now(),
+                .level = MessageLevel::WARNING,
+                .message = "not\nwritten"};
+        MessageFormatter formatter({{FieldType::Name, 0, ""}, {FieldType::Level, 0, ""}}, "|");
+        ASYNCQUEUE_CHECK(formatter.format(message) == "Src|WARNING\n");
+    }
+} // namespace
+
+int main() {
+    std::vector<Message> messages = makeMessages();
+    checkDefault(messages);
+    checkCustom(messages);
+    checkMultipleMessageFields(messages);
+    checkNoMessageField();
+    return 0;
+}
@@ -0,0 +1,263 @@
+/**
+ * @file OverflowPolicy.cxx
+ * @brief Bounded queues must apply their overflow policy and count what they discard
+ *
+ * The policies are checked on a bare AsyncQueue, then through a ManagedQueue whose consumer is
+ * held up so that the queue fills. A producer blocked on a full queue must be released when space
+ * is made, when the stop is requested and when the consumer halts, including message sources
+ * created by a MessageManager.
+ */
+
+#include "Check.hxx"
+
+#include "AsyncQueue/AsyncQueue.hxx"
+#include "AsyncQueue/IConsumer.hxx"
+#include "AsyncQueue/ManagedQueue.hxx"
+#include "AsyncQueue/Message.hxx"
+#include "AsyncQueue/MessageManager.hxx"
+#include "AsyncQueue/MessageSource.hxx"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stop_token>
+#include <vector>
+
+namespace {
+    using namespace AsyncQueue;
+    using namespace std::chrono_literals;
+
+    constexpr std::size_t capacity = 3;
+    constexpr int nPushed = 5;
+
+    /// @brief Long enough that a push which should block will have done so
+    constexpr auto blockTime = 50ms;
+    /// @brief Long enough that a push which should be released will have returned
+    constexpr auto releaseTime = 2s;
+
+    std::vector<int> drain(::AsyncQueue::AsyncQueue<int> &queue) {
+        std::vector<int> values;
+        while (auto value = queue.extract())
+            values.push_back(*value);
+        return values;
+    }
+
+    Message makeMessage(MessageLevel lvl) {
+        return {.source = "Overflow",
+                .time = std::chrono::system_clock::now(),
+                .level = lvl,
+                .message = "text"};
+    }
+
+    void checkDropNewest() {
+        ::AsyncQueue::AsyncQueue<int> queue;
+        queue.setCapacity(capacity, OverflowPolicy::DropNewest);
+        for (int value = 0; value < nPushed; ++value)
+            ASYNCQUEUE_CHECK(queue.push(value) == (value < static_cast<int>(capacity)));
+        ASYNCQUEUE_CHECK(drain(queue) == std::vector<int>({0, 1, 2}));
+        DropCounts drops = queue.dropCounts();
+        ASYNCQUEUE_CHECK(drops.newest == nPushed - capacity);
+        ASYNCQUEUE_CHECK(drops.total() == drops.newest);
+    }
+
+    void checkDropOldest() {
+        ::AsyncQueue::AsyncQueue<int> queue;
+        queue.setCapacity(capacity, OverflowPolicy::DropOldest);
+        for (int value = 0; value < nPushed; ++value)
+            ASYNCQUEUE_CHECK(queue.push(value));
+        ASYNCQUEUE_CHECK(drain(queue) == std::vector<int>({2, 3, 4}));
+        DropCounts drops = queue.dropCounts();
+        ASYNCQUEUE_CHECK(drops.oldest == nPushed - capacity);
+        ASYNCQUEUE_CHECK(drops.total() == drops.oldest);
+    }
+
+    /// @brief Messages below the level are dropped when full, the others wait for space
+    void checkDropBelowLevel() {
+        MessageQueue queue;
+        queue.setCapacity(capacity, MessageLevel::WARNING);
+        for (std::size_t idx = 0; idx < capacity; ++idx)
+            ASYNCQUEUE_CHECK(queue.push(makeMessage(MessageLevel::ERROR)));
+        ASYNCQUEUE_CHECK(!queue.push(makeMessage(MessageLevel::INFO)));
+        ASYNCQUEUE_CHECK(!queue.push(makeMessage(MessageLevel::DEBUG)));
+        ASYNCQUEUE_CHECK(queue.dropCounts().belowLevel == 2);
+
+        std::stop_source ss;
+        auto pushed = std::async(std::launch::async, [&]() {
+            return queue.push(makeMessage(MessageLevel::WARNING), ss.get_token());
+        });
+        ASYNCQUEUE_CHECK(pushed.wait_for(blockTime) == std::future_status::timeout);
+        ASYNCQUEUE_CHECK(queue.extract()->level == MessageLevel::ERROR);
+        ASYNCQUEUE_CHECK(pushed.get());
+        ASYNCQUEUE_CHECK(queue.size() == capacity);
+        DropCounts drops = queue.dropCounts();
+        ASYNCQUEUE_CHECK(drops.total() == drops.belowLevel);
+    }
+
+    /// @brief A blocked push waits for space and gives up, counted as interrupted, on a stop
+    void checkBlock() {
+        ::AsyncQueue::AsyncQueue<int> queue;
+        queue.setCapacity(capacity, OverflowPolicy::Block);
+        for (int value = 0; value < static_cast<int>(capacity); ++value)
+            ASYNCQUEUE_CHECK(queue.push(value));
+
+        std::stop_source ss;
+        auto pushed =
+                std::async(std::launch::async, [&]() { return queue.push(3, ss.get_token()); });
+        ASYNCQUEUE_CHECK(pushed.wait_for(blockTime) == std::future_status::timeout);
+        ASYNCQUEUE_CHECK(queue.extract() == 0);
+        ASYNCQUEUE_CHECK(pushed.get());
+
+        pushed = std::async(std::launch::async, [&]() { return queue.push(4, ss.get_token()); });
+        ASYNCQUEUE_CHECK(pushed.wait_for(blockTime) == std::future_status::timeout);
+        ss.request_stop();
+        ASYNCQUEUE_CHECK(pushed.wait_for(releaseTime) == std::future_status::ready);
+        ASYNCQUEUE_CHECK(!pushed.get());
+        ASYNCQUEUE_CHECK(drain(queue) == std::vector<int>({1, 2, 3}));
+        DropCounts drops = queue.dropCounts();
+        ASYNCQUEUE_CHECK(drops.interrupted == 1);
+        ASYNCQUEUE_CHECK(drops.total() == drops.interrupted);
+    }
+
+    /// @brief Consumer which holds on to the first element until it is released
+    class Held : public IConsumer<int> {
+    public:
+        Held(TaskStatus status) : m_status(status) {}
+        TaskStatus consume(const int &) override {
+            if (!m_started) {
+                m_started = true;
+                started.set_value();
+                release.get_future().wait();
+            }
+            return m_status;
+        }
+        /// @brief Set when the consumer receives its first element
+        std::promise<void> started;
+        /// @brief Set to let the consumer continue
+        std::promise<void> release;
+
+    private:
+        TaskStatus m_status;
+        bool m_started{false};
+    };
+
+    /// @brief Fill a managed queue whose consumer is held on its first element
+    template <typename Queue> void fill(Queue &queue, Held &consumer) {
+        ASYNCQUEUE_CHECK(queue.push(-1));
+        consumer.started.get_future().wait();
+        for (int value = 0; value < static_cast<int>(capacity); ++value)
+            ASYNCQUEUE_CHECK(queue.push(value));
+    }
+
+    /// @brief A producer blocked on a managed queue is released when the consumer makes space
+    void checkManagedBlock() {
+        Held consumer(TaskStatus::CONTINUE);
+        ManagedQueue<int> queue(std::stop_source(), &consumer);
+        queue.setCapacity(capacity, OverflowPolicy::Block);
+        fill(queue, consumer);
+        auto pushed = std::async(std::launch::async, [&]() { return queue.push(3); });
+        ASYNCQUEUE_CHECK(pushed.wait_for(blockTime) == std::future_status::timeout);
+        consumer.release.set_value();
+        ASYNCQUEUE_CHECK(pushed.get());
+        ASYNCQUEUE_CHECK(queue.dropCounts().total() == 0);
+    }
+
+    /// @brief A producer blocked on a managed queue is released when the stop is requested
+    void checkManagedStop() {
+        Held consumer(TaskStatus::CONTINUE);
+        ManagedQueue<int> queue(std::stop_source(), &consumer);
+        queue.setCapacity(capacity, OverflowPolicy::Block);
+        fill(queue, consumer);
+        auto pushed = std::async(std::launch::async, [&]() { return queue.push(3); });
+        ASYNCQUEUE_CHECK(pushed.wait_for(blockTime) == std::future_status::timeout);
+        queue.stopSource().request_stop();
+        ASYNCQUEUE_CHECK(pushed.wait_for(releaseTime) == std::future_status::ready);
+        ASYNCQUEUE_CHECK(!pushed.get());
+        ASYNCQUEUE_CHECK(queue.dropCounts().interrupted == 1);
+        ASYNCQUEUE_CHECK(!queue.push(4));
+        consumer.release.set_value();
+    }
+
+    /// @brief A producer blocked on a managed queue is released when the consumer halts, and
+    ///        later pushes are refused rather than waiting for space
+    void checkManagedHalt() {
+        Held consumer(TaskStatus::HALT);
+        ManagedQueue<int> queue(std::stop_source(), &consumer);
+        queue.setCapacity(capacity, OverflowPolicy::Block);
+        fill(queue, consumer);
+        auto pushed = std::async(std::launch::async, [&]() { return queue.push(3); });
+        ASYNCQUEUE_CHECK(pushed.wait_for(blockTime) == std::future_status::timeout);
+        consumer.release.set_value();
+        ASYNCQUEUE_CHECK(pushed.wait_for(releaseTime) == std::future_status::ready);
+        ASYNCQUEUE_CHECK(!pushed.get());
+        ASYNCQUEUE_CHECK(queue.consumerStatus().get() == TaskStatus::HALT);
+        ASYNCQUEUE_CHECK(queue.closedToken().stop_requested());
+        ASYNCQUEUE_CHECK(!queue.push(4));
+        ASYNCQUEUE_CHECK(queue.size() == capacity);
+    }
+
+    /// @brief Writer which halts on the first message it receives
+    class HaltingWriter : public IMessageWriter {
+    public:
+        TaskStatus consume(const Message &) override { return TaskStatus::HALT; }
+    };
+
+    /// @brief Logging must never block once the manager's writer has halted, whichever way the
+    ///        message is built
+    void checkSourceAfterHalt() {
+        MessageManager manager(std::stop_source(), std::make_unique<HaltingWriter>());
+        manager.setCapacity(2, OverflowPolicy::Block);
+        MessageSource source = manager.createSource("Source");
+        MessageSource subSource = source.createSubSource("Sub");
+        auto logged = std::async(std::launch::async, [&]() {
+            for (int idx = 0; idx < 10; ++idx) {
+                source.infoMsg("message ", idx);
+                source.infoFmt("message {}", idx);
+                subSource << MessageLevel::WARNING << "message " << idx;
+            }
+        });
+        ASYNCQUEUE_CHECK(logged.wait_for(releaseTime) == std::future_status::ready);
+        logged.get();
+    }
+
+    /// @brief The same, with the manager's stop requested while a source is blocked
+    void checkSourceAfterStop() {
+        std::stop_source ss;
+        std::promise<void> release;
+        class HeldWriter : public IMessageWriter {
+        public:
+            HeldWriter(std::shared_future<void> release) : m_release(std::move(release)) {}
+            TaskStatus consume(const Message &) override {
+                m_release.wait();
+                return TaskStatus::CONTINUE;
+            }
+
+        private:
+            std::shared_future<void> m_release;
+        };
+        MessageManager manager(ss, std::make_unique<HeldWriter>(release.get_future().share()));
+        manager.setCapacity(2, OverflowPolicy::Block);
+        MessageSource source = manager.createSource("Source");
+        auto logged = std::async(std::launch::async, [&]() {
+            for (int idx = 0; idx < 10; ++idx)
+                source.infoMsg("message ", idx);
+        });
+        ASYNCQUEUE_CHECK(logged.wait_for(blockTime) == std::future_status::timeout);
+        ss.request_stop();
+        ASYNCQUEUE_CHECK(logged.wait_for(releaseTime) == std::future_status::ready);
+        logged.get();
+        release.set_value();
+    }
+} // namespace
+
+int main() {
+    checkDropNewest();
+    checkDropOldest();
+    checkDropBelowLevel();
+    checkBlock();
+    checkManagedBlock();
+    checkManagedStop();
+    checkManagedHalt();
+    checkSourceAfterHalt();
+    checkSourceAfterStop();
+    return 0;
+}
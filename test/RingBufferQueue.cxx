@@ -0,0 +1,211 @@
+/**
+ * @file RingBufferQueue.cxx
+ * @brief Ordering, blocking and exception safety of the lock-free ring buffer queues
+ *
+ * Producers and consumers are run concurrently on small queues so that both sides regularly find
+ * the queue full or empty and have to park.
+ */
+
+#include "Check.hxx"
+
+#include "AsyncQueue/RingBufferQueue.hxx"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+    using namespace AsyncQueue;
+    using namespace std::chrono_literals;
+
+    constexpr std::size_t capacity = 16;
+    constexpr std::size_t nElements = 100000;
+
+    /// @brief An element tagged with its producer and its position in that producer's sequence
+    struct Tagged {
+        std::size_t producer;
+        std::size_t sequence;
+    };
+
+    /// @brief Extract elements until count have been received, waiting whenever the queue is empty
+    template <typename Queue, typename F>
+    void drain(Queue &queue, std::atomic<std::size_t> &count, std::size_t total, F &&f) {
+        std::stop_source ss;
+        while (count.load() < total) {
+            if (auto next = queue.extract()) {
+                count.fetch_add(1);
+                f(*next);
+            } else
+                queue.waitForElements(ss.get_token(), 1, std::chrono::steady_clock::now() + 1ms);
+        }
+    }
+
+    /// @brief One producer and one consumer must see every element, in order
+    void checkSPSC() {
+        SPSCQueue<std::size_t, capacity> queue;
+        std::atomic<std::size_t> count{0};
+        std::size_t expected = 0;
+        bool ordered = true;
+        std::jthread producer([&queue]() {
+            for (std::size_t idx = 0; idx < nElements; ++idx)
+                queue.push(idx);
+        });
+        drain(queue, count, nElements, [&](std::size_t value) { ordered &= value == expected++; });
+        producer.join();
+        ASYNCQUEUE_CHECK(ordered);
+        ASYNCQUEUE_CHECK(expected == nElements);
+        ASYNCQUEUE_CHECK(queue.empty());
+    }
+
+    /// @brief Every element must be received exactly once, and each consumer must see the
+    ///        elements of each producer in the order they were pushed
+    void checkMPMC() {
+        constexpr std::size_t nProducers = 4;
+        constexpr std::size_t nConsumers = 4;
+        constexpr std::size_t perProducer = nElements / nProducers;
+        MPMCQueue<Tagged, capacity> queue;
+        std::atomic<std::size_t> count{0};
+        std::vector<std::vector<std::atomic<bool>>> seen(nProducers);
+        for (auto &producerSeen : seen)
+            producerSeen = std::vector<std::atomic<bool>>(perProducer);
+        std::atomic<bool> duplicated{false};
+        std::atomic<bool> reordered{false};
+        {
+            std::vector<std::jthread> threads;
+            for (std::size_t producer = 0; producer < nProducers; ++producer)
+                threads.emplace_back([&queue, producer]() {
+                    for (std::size_t idx = 0; idx < perProducer; ++idx)
+                        queue.push(Tagged{producer, idx});
+                });
+            for (std::size_t consumer = 0; consumer < nConsumers; ++consumer)
+                threads.emplace_back([&]() {
+                    std::vector<std::size_t> next(nProducers, 0);
+                    drain(queue, count, nProducers * perProducer, [&](const Tagged &value) {
+                        if (value.sequence < next[value.producer])
+                            reordered = true;
+                        next[value.producer] = value.sequence + 1;
+                        if (seen[value.producer][value.sequence].exchange(true))
+                            duplicated = true;
+                    });
+                });
+        }
+        ASYNCQUEUE_CHECK(count.load() == nProducers * perProducer);
+        ASYNCQUEUE_CHECK(!duplicated.load());
+        ASYNCQUEUE_CHECK(!reordered.load());
+        for (const auto &producerSeen : seen)
+            for (const std::atomic<bool> &element : producerSeen)
+                ASYNCQUEUE_CHECK(element.load());
+        ASYNCQUEUE_CHECK(queue.empty());
+    }
+
+    /// @brief Producers must wait on a full queue and consumers on an empty one, and both waits
+    ///        must end when space or an element arrives or when a stop is requested
+    template <RingBufferMode Mode> void checkWaits() {
+        RingBufferQueue<int, 4, Mode> queue;
+
+        // Empty queue: the wait ends on a stop, then on a push
+        std::stop_source stopWait;
+        auto waited = std::async(std::launch::async, [&]() {
+            return queue.waitForElement(stopWait.get_token());
+        });
+        ASYNCQUEUE_CHECK(waited.wait_for(50ms) == std::future_status::timeout);
+        stopWait.request_stop();
+        ASYNCQUEUE_CHECK(!waited.get());
+        ASYNCQUEUE_CHECK(!queue.waitForElements(
+                std::stop_token(), 1, std::chrono::steady_clock::now() + 10ms));
+        std::stop_source neverStopped;
+        waited = std::async(std::launch::async, [&]() {
+            return queue.waitForElement(neverStopped.get_token());
+        });
+        ASYNCQUEUE_CHECK(waited.wait_for(50ms) == std::future_status::timeout);
+        queue.push(-1);
+        ASYNCQUEUE_CHECK(waited.get());
+        ASYNCQUEUE_CHECK(queue.extract() == -1);
+
+        // Full queue: tryPush fails, a push waits for space or a stop
+        for (int idx = 0; idx < 4; ++idx)
+            ASYNCQUEUE_CHECK(queue.tryPush(idx));
+        ASYNCQUEUE_CHECK(queue.full());
+        ASYNCQUEUE_CHECK(!queue.tryPush(4));
+        std::stop_source stopPush;
+        auto pushed = std::async(std::launch::async, [&]() {
+            return queue.push(4, stopPush.get_token());
+        });
+        ASYNCQUEUE_CHECK(pushed.wait_for(50ms) == std::future_status::timeout);
+        stopPush.request_stop();
+        ASYNCQUEUE_CHECK(!pushed.get());
+        pushed = std::async(std::launch::async, [&]() {
+            return queue.push(4, neverStopped.get_token());
+        });
+        ASYNCQUEUE_CHECK(pushed.wait_for(50ms) == std::future_status::timeout);
+        ASYNCQUEUE_CHECK(queue.extract() == 0);
+        ASYNCQUEUE_CHECK(pushed.get());
+        for (int idx = 1; idx <= 4; ++idx)
+            ASYNCQUEUE_CHECK(queue.extract() == idx);
+        ASYNCQUEUE_CHECK(queue.empty());
+    }
+
+    /// @brief An element whose copy constructor can be made to throw
+    struct Throwing {
+        Throwing(int value, bool fail = false) : value(value), fail(fail) {}
+        Throwing(const Throwing &other) : value(other.value), fail(other.fail) {
+            if (fail)
+                throw std::runtime_error("copy failed");
+        }
+        Throwing(Throwing &&other) noexcept = default;
+        int value;
+        bool fail;
+    };
+
+    /// @brief A push whose element constructor throws must not leave a hole which stalls the
+    ///        consumers: the slot is skipped and later reused
+    void checkTombstone() {
+        MPMCQueue<Throwing, 4> queue;
+        auto pushThrowing = [&queue]() {
+            Throwing bad(-1, true);
+            try {
+                queue.tryPush(bad);
+            } catch (const std::runtime_error &) {
+                return true;
+            }
+            return false;
+        };
+        ASYNCQUEUE_CHECK(queue.tryPush(Throwing(1)));
+        ASYNCQUEUE_CHECK(pushThrowing());
+        ASYNCQUEUE_CHECK(queue.tryPush(Throwing(2)));
+        ASYNCQUEUE_CHECK(queue.extract()->value == 1);
+        ASYNCQUEUE_CHECK(queue.extract()->value == 2);
+        ASYNCQUEUE_CHECK(!queue.extract());
+
+        // A failed push into an empty queue, seen by a waiting consumer
+        std::stop_source ss;
+        auto waited = std::async(
+                std::launch::async, [&]() { return queue.waitForElement(ss.get_token()); });
+        ASYNCQUEUE_CHECK(pushThrowing());
+        ASYNCQUEUE_CHECK(waited.get());
+        ASYNCQUEUE_CHECK(!queue.extract());
+
+        // Every slot, including those which held tombstones, can be filled again
+        for (int idx = 0; idx < 4; ++idx)
+            ASYNCQUEUE_CHECK(queue.tryPush(Throwing(idx)));
+        ASYNCQUEUE_CHECK(!queue.tryPush(Throwing(4)));
+        for (int idx = 0; idx < 4; ++idx)
+            ASYNCQUEUE_CHECK(queue.extract()->value == idx);
+        ASYNCQUEUE_CHECK(queue.empty());
+    }
+} // namespace
+
+int main() {
+    checkSPSC();
+    checkMPMC();
+    checkWaits<RingBufferMode::SPSC>();
+    checkWaits<RingBufferMode::MPMC>();
+    checkTombstone();
+    return 0;
+}
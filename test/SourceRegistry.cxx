@@ -0,0 +1,97 @@
+/**
+ * @file SourceRegistry.cxx
+ * @brief Source names must stay valid whether or not the registry had room to intern them
+ *
+ * The registry is filled to its capacity, after which new names are owned by the SourceName
+ * itself. Names of both kinds must survive the strings they were created from and be written to
+ * and read back from a binary log.
+ */
+
+#include "Check.hxx"
+
+#include "AsyncQueue/BinaryLog.hxx"
+#include "AsyncQueue/BinaryMessageWriter.hxx"
+#include "AsyncQueue/Message.hxx"
+#include "AsyncQueue/SourceRegistry.hxx"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+    using namespace AsyncQueue;
+    namespace fs = std::filesystem;
+
+    constexpr std::size_t nExtra = 3;
+
+    /// @brief Create a name from a temporary string which is destroyed straight away
+    SourceName makeName(const std::string &base, std::size_t idx) {
+        return SourceName(base + std::to_string(idx));
+    }
+
+    /// @brief Names created once the registry is full are owned rather than interned
+    std::vector<SourceName> checkCapacity() {
+        SourceRegistry &registry = SourceRegistry::global();
+        ASYNCQUEUE_CHECK(registry.capacity() == SourceRegistry::defaultCapacity);
+        SourceName interned("Interned");
+        registry.setCapacity(registry.size() + nExtra);
+
+        std::vector<SourceName> names;
+        for (std::size_t idx = 0; idx < 2 * nExtra; ++idx)
+            names.push_back(makeName("Source", idx));
+        ASYNCQUEUE_CHECK(registry.size() == registry.capacity());
+        for (std::size_t idx = 0; idx < names.size(); ++idx) {
+            ASYNCQUEUE_CHECK(names[idx] == "Source" + std::to_string(idx));
+            ASYNCQUEUE_CHECK((names[idx].id() == invalidSourceId) == (idx >= nExtra));
+        }
+
+        // Existing names are still found, and copies of owned names share the same text
+        ASYNCQUEUE_CHECK(SourceName("Interned").id() == interned.id());
+        ASYNCQUEUE_CHECK(SourceName("Source0").id() == names[0].id());
+        SourceName copy = names.back();
+        ASYNCQUEUE_CHECK(copy.view().data() == names.back().view().data());
+        SourceName moved = std::move(copy);
+        ASYNCQUEUE_CHECK(moved == "Source" + std::to_string(2 * nExtra - 1));
+        return names;
+    }
+
+    /// @brief Both kinds of name are written to each segment's dictionary
+    void checkBinaryLog(const std::vector<SourceName> &names) {
+        fs::path dir = fs::temp_directory_path() /
+                       ("AsyncQueueSourceRegistry." + std::to_string(::getpid()));
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        const std::string prefix = (dir / "log").string();
+        std::vector<Message> messages;
+        for (std::size_t repeat = 0; repeat < 2; ++repeat)
+            for (const SourceName &name : names)
+                messages.push_back(
+                        {.source = name,
+                         .time = std::chrono::system_clock::now(),
+                         .level = MessageLevel::INFO,
+                         .message = "text"});
+        {
+            BinaryMessageWriter writer(prefix);
+            writer.consume(messages);
+            ASYNCQUEUE_CHECK(writer.droppedMessages() == 0);
+        }
+        std::vector<std::string> read;
+        for (const std::string &path : findBinaryLogSegments(prefix))
+            BinaryLogSegment(path).forEach([&read](const BinaryLogRecord &record) {
+                read.emplace_back(record.source);
+            });
+        ASYNCQUEUE_CHECK(read.size() == messages.size());
+        for (std::size_t idx = 0; idx < read.size(); ++idx)
+            ASYNCQUEUE_CHECK(messages[idx].source == read[idx]);
+        fs::remove_all(dir);
+    }
+} // namespace
+
+int main() {
+    std::vector<SourceName> names = checkCapacity();
+    checkBinaryLog(names);
+    return 0;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file ReadBinaryLog.cxx
+ * @brief Print the messages in a binary log as text
+ *
+ * Usage: ReadBinaryLog [options] <log>...
+ *
+ * Each log is either a segment file or the path prefix given to the BinaryMessageWriter, in which
+ * case all of its segments are read in order. Segments are memory-mapped and filtered on the
+ * fixed size part of each record, so only matching messages are copied and formatted.
+ */
+
+#include "AsyncQueue/BinaryLog.hxx"
+#include "AsyncQueue/MessageFormatter.hxx"
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <exception>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    using namespace AsyncQueue;
+    using time_point_t = std::chrono::time_point<std::chrono::system_clock>;
+
+    constexpr std::size_t outputBufferSize = 1 << 16;
+
+    void usage(std::ostream &os) {
+        os << "Usage: ReadBinaryLog [options] <log>...\n"
+              "\n"
+              "Print the messages in binary logs written by BinaryMessageWriter. Each log is a\n"
+              "segment file or the path prefix of its segments.\n"
+              "\n"
+              "Options:\n"
+              "  -l, --level LEVEL   Only print messages at or above LEVEL\n"
+              "  -s, --source NAME   Only print messages from NAME or its subsources. May be\n"
+              "                      given more than once\n"
+              "      --since TIME    Only print messages at or after TIME\n"
+              "      --until TIME    Only print messages before TIME\n"
+              "  -h, --help          Print this message\n"
+              "\n"
+              "TIME is either seconds since the epoch or a local time formatted as\n"
+              "\"YYYY-MM-DD HH:MM:SS\".\n";
+    }
+
+    time_point_t parseTime(const std::string &value) {
+        if (!value.empty() && value.find_first_not_of("0123456789") == std::string::npos)
+            return time_point_t(std::chrono::seconds(std::stoll(value)));
+        for (const char *format : {"%Y-%m-%d %H:%M:%S", "%Y-%m-%dT%H:%M:%S"}) {
+            std::tm tm{};
+            std::istringstream iss(value);
+            iss >> std::get_time(&tm, format);
+            if (!iss.fail()) {
+                tm.tm_isdst = -1;
+                return std::chrono::system_clock::from_time_t(std::mktime(&tm));
+            }
+        }
+        throw std::invalid_argument("Cannot parse time '" + value + "'");
+    }
+
+    MessageLevel parseLevel(const std::string &value) {
+        try {
+            return levelFromString(value);
+        } catch (const std::invalid_argument &) {
+            throw std::invalid_argument("Unknown message level '" + value + "'");
+        }
+    }
+
+    /// @brief The criteria a message must meet to be printed
+    struct Filter {
+        MessageLevel level{MessageLevel::VERBOSE};
+        std::vector<std::string> sources;
+        std::optional<time_point_t> since;
+        std::optional<time_point_t> until;
+
+        bool operator()(const BinaryLogRecord &record) const {
+            if (record.level < level || (since && record.time < *since) ||
+                (until && record.time >= *until))
+                return false;
+            if (sources.empty())
+                return true;
+            for (const std::string &source : sources)
+                if (record.source == source ||
+                    (record.source.starts_with(source) && record.source.size() > source.size() &&
+                     record.source[source.size()] == ':'))
+                    return true;
+            return false;
+        }
+    };
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Filter filter;
+    std::vector<std::string> logs;
+    try {
+        for (int idx = 1; idx < argc; ++idx) {
+            std::string_view arg(argv[idx]);
+            auto value = [&]() -> std::string {
+                if (idx + 1 >= argc)
+                    throw std::invalid_argument("Missing value for " + std::string(arg));
+                return argv[++idx];
+            };
+            if (arg == "-h" || arg == "--help") {
+                usage(std::cout);
+                return 0;
+            } else if (arg == "-l" || arg == "--level")
+                filter.level = parseLevel(value());
+            else if (arg == "-s" || arg == "--source")
+                filter.sources.push_back(value());
+            else if (arg == "--since")
+                filter.since = parseTime(value());
+            else if (arg == "--until")
+                filter.until = parseTime(value());
+            else if (arg.starts_with("-"))
+                throw std::invalid_argument("Unknown option " + std::string(arg));
+            else
+                logs.emplace_back(arg);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "ReadBinaryLog: " << e.what() << "\n\n";
+        usage(std::cerr);
+        return 1;
+    }
+    if (logs.empty()) {
+        usage(std::cerr);
+        return 1;
+    }
+
+    MessageFormatter formatter;
+    std::string output;
+    output.reserve(outputBufferSize);
+    int status = 0;
+    for (const std::string &log : logs) {
+        std::vector<std::string> segments;
+        if (std::filesystem::is_regular_file(log))
+            segments.push_back(log);
+        else
+            segments = findBinaryLogSegments(log);
+        if (segments.empty()) {
+            std::cerr << "ReadBinaryLog: No segments found for " << log << "\n";
+            status = 1;
+        }
+        for (const std::string &path : segments) {
+            try {
+                BinaryLogSegment segment(path);
+                segment.forEach([&](const BinaryLogRecord &record) {
+                    if (!filter(record))
+                        return;
+                    formatter.format(record.toMessage(), output);
+                    if (output.size() >= outputBufferSize) {
+                        std::fwrite(output.data(), 1, output.size(), stdout);
+                        output.clear();
+                    }
+                });
+            } catch (const std::exception &e) {
+                std::cerr << "ReadBinaryLog: " << e.what() << "\n";
+                status = 1;
+            }
+        }
+    }
+    std::fwrite(output.data(), 1, output.size(), stdout);
+    return status;
+}